@@ -4,7 +4,12 @@
       "target_name": "xattr",
       "sources": [
         "src/async.c",
+        "src/attribute_dir.c",
+        "src/attribute_index.c",
+        "src/chunked.c",
         "src/error.c",
+        "src/instance.c",
+        "src/shared.c",
         "src/sync.c",
         "src/util.c",
         "src/xattr.c"
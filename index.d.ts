@@ -1,38 +1,104 @@
+export type AttributeEncoding = 'buffer' | 'utf8' | 'latin1' | 'uint64le' | 'json'
+
+export interface EncodingOptions<T extends AttributeEncoding> {
+  /** How the value is decoded or encoded, defaults to `'buffer'`. */
+  encoding?: T
+  /** Read a value written with `chunked` or `compress`. Plain values are returned as-is. */
+  chunked?: boolean
+}
+
+export interface SetOptions<T extends AttributeEncoding = AttributeEncoding> extends EncodingOptions<T> {
+  /** Split the value over `attr`, `attr#<generation>.1`, `attr#<generation>.2`, ... so that it can exceed the size limit of a single attribute. */
+  chunked?: boolean
+  /** Deflate the value before storing it, implies `chunked`. */
+  compress?: boolean
+  /** Maximum size of each attribute in bytes, defaults to `2048`. */
+  chunkSize?: number
+}
+
+export interface JsonSetOptions extends SetOptions<'json'> {
+  /** Store the value as JSON. */
+  encoding: 'json'
+}
+
+export interface RemoveOptions {
+  /** Also remove the numbered attributes of a value written with `chunked`. */
+  chunked?: boolean
+}
+
+type DecodedValue<T extends AttributeEncoding> = T extends 'utf8' | 'latin1' ? string : T extends 'uint64le' ? bigint : T extends 'json' ? unknown : Buffer
+
 /**
- * Get extended attribute `attr` from file at `path`.
+ * Get extended attribute `attr` from file at `path`. The value is decoded according to `encoding`: `'utf8'` and `'latin1'` give a string, `'uint64le'` a `bigint` and `'json'` the parsed value.
  *
  * @returns a `Promise` that will resolve with the value of the attribute.
  */
-export function getAttribute (path: string, attr: string): Promise<Buffer>
+export function getAttribute<T extends AttributeEncoding = 'buffer'> (path: string, attr: string, options?: EncodingOptions<T>): Promise<DecodedValue<T>>
 
 /**
  * Synchronous version of `getAttribute`.
  */
-export function getAttributeSync (path: string, attr: string): Buffer
+export function getAttributeSync<T extends AttributeEncoding = 'buffer'> (path: string, attr: string, options?: EncodingOptions<T>): DecodedValue<T>
+
+/**
+ * Set extended attribute `attr` to `value` on file at `path`. Strings are stored as UTF-8, numbers and bigints as unsigned 64-bit little-endian integers and buffers as-is.
+ *
+ * @returns a `Promise` that will resolve when the value has been set.
+ */
+export function setAttribute (path: string, attr: string, value: Buffer | string | number | bigint, options?: SetOptions<'buffer'>): Promise<void>
+
+/**
+ * Set extended attribute `attr` to the string `value`, encoded as UTF-8 or Latin-1 according to `encoding`. Buffers are stored as-is.
+ *
+ * @returns a `Promise` that will resolve when the value has been set.
+ */
+export function setAttribute (path: string, attr: string, value: Buffer | string, options: SetOptions<'utf8' | 'latin1'>): Promise<void>
 
 /**
- * Set extended attribute `attr` to `value` on file at `path`.
+ * Set extended attribute `attr` to the unsigned 64-bit integer `value`, stored little-endian. Buffers are stored as-is.
  *
  * @returns a `Promise` that will resolve when the value has been set.
  */
-export function setAttribute (path: string, attr: string, value: Buffer | string): Promise<void>
+export function setAttribute (path: string, attr: string, value: Buffer | number | bigint, options: SetOptions<'uint64le'>): Promise<void>
+
+/**
+ * Set extended attribute `attr` to `value` serialized as JSON. Buffers are stored as-is.
+ *
+ * @returns a `Promise` that will resolve when the value has been set.
+ */
+export function setAttribute (path: string, attr: string, value: unknown, options: JsonSetOptions): Promise<void>
 
 /**
  * Synchronous version of `setAttribute`.
  */
-export function setAttributeSync (path: string, attr: string, value: Buffer | string): void
+export function setAttributeSync (path: string, attr: string, value: Buffer | string | number | bigint, options?: SetOptions<'buffer'>): void
+
+/**
+ * Synchronous version of `setAttribute` with `encoding: 'utf8'` or `'latin1'`.
+ */
+export function setAttributeSync (path: string, attr: string, value: Buffer | string, options: SetOptions<'utf8' | 'latin1'>): void
+
+/**
+ * Synchronous version of `setAttribute` with `encoding: 'uint64le'`.
+ */
+export function setAttributeSync (path: string, attr: string, value: Buffer | number | bigint, options: SetOptions<'uint64le'>): void
+
+/**
+ * Synchronous version of `setAttribute` with `encoding: 'json'`.
+ */
+export function setAttributeSync (path: string, attr: string, value: unknown, options: JsonSetOptions): void
 
 /**
  * Remove extended attribute `attr` on file at `path`.
  *
  * @returns a `Promise` that will resolve when the value has been removed.
  */
-export function removeAttribute (path: string, attr: string): Promise<void>
+export function removeAttribute (path: string, attr: string, options?: RemoveOptions): Promise<void>
 
 /**
  * Synchronous version of `removeAttribute`.
  */
-export function removeAttributeSync (path: string, attr: string): void
+export function removeAttributeSync (path: string, attr: string, options?: RemoveOptions): void
 
 /**
  * List all attributes on file at `path`.
@@ -45,3 +111,141 @@ export function listAttributes (path: string): Promise<string[]>
  * Synchronous version of `listAttributes`.
  */
 export function listAttributesSync (path: string): string[]
+
+export interface DirOptions {
+  /** Operate on a symbolic link itself rather than on the file it points to. */
+  noFollow?: boolean
+}
+
+export interface DirEncodingOptions<T extends AttributeEncoding = AttributeEncoding> extends DirOptions {
+  /** How the value is decoded or encoded, defaults to `'buffer'`. */
+  encoding?: T
+}
+
+export interface JsonDirOptions extends DirEncodingOptions<'json'> {
+  /** Store the value as JSON. */
+  encoding: 'json'
+}
+
+export interface AttributeDir {
+  /**
+   * Get extended attribute `attr` from the entry `name` in the directory.
+   *
+   * @returns a `Promise` that will resolve with the value of the attribute.
+   */
+  get<T extends AttributeEncoding = 'buffer'> (name: string, attr: string, options?: DirEncodingOptions<T>): Promise<DecodedValue<T>>
+
+  /**
+   * Synchronous version of `get`.
+   */
+  getSync<T extends AttributeEncoding = 'buffer'> (name: string, attr: string, options?: DirEncodingOptions<T>): DecodedValue<T>
+
+  /**
+   * Set extended attribute `attr` to `value` on the entry `name` in the directory.
+   *
+   * @returns a `Promise` that will resolve when the value has been set.
+   */
+  set (name: string, attr: string, value: Buffer | string | number | bigint, options?: DirEncodingOptions<'buffer'>): Promise<void>
+  set (name: string, attr: string, value: Buffer | string, options: DirEncodingOptions<'utf8' | 'latin1'>): Promise<void>
+  set (name: string, attr: string, value: Buffer | number | bigint, options: DirEncodingOptions<'uint64le'>): Promise<void>
+  set (name: string, attr: string, value: unknown, options: JsonDirOptions): Promise<void>
+
+  /**
+   * Synchronous version of `set`.
+   */
+  setSync (name: string, attr: string, value: Buffer | string | number | bigint, options?: DirEncodingOptions<'buffer'>): void
+  setSync (name: string, attr: string, value: Buffer | string, options: DirEncodingOptions<'utf8' | 'latin1'>): void
+  setSync (name: string, attr: string, value: Buffer | number | bigint, options: DirEncodingOptions<'uint64le'>): void
+  setSync (name: string, attr: string, value: unknown, options: JsonDirOptions): void
+
+  /**
+   * List all attributes on the entry `name` in the directory.
+   *
+   * @returns a `Promise` that will resolve with an array of strings.
+   */
+  list (name: string, options?: DirOptions): Promise<string[]>
+
+  /**
+   * Synchronous version of `list`.
+   */
+  listSync (name: string, options?: DirOptions): string[]
+
+  /**
+   * Remove extended attribute `attr` on the entry `name` in the directory.
+   *
+   * @returns a `Promise` that will resolve when the value has been removed.
+   */
+  remove (name: string, attr: string, options?: DirOptions): Promise<void>
+
+  /**
+   * Synchronous version of `remove`.
+   */
+  removeSync (name: string, attr: string, options?: DirOptions): void
+
+  /**
+   * Close the directory, once any pending operations have finished. Any further calls will throw.
+   */
+  close (): void
+}
+
+/**
+ * Open the directory at `path`, so that its entries can be accessed by their name relative to it without resolving the full path on every call.
+ */
+export function openAttributeDir (path: string): AttributeDir
+
+export interface AttributeIndexOptions {
+  /** Only include attributes with one of these names. */
+  names?: string[]
+  /** Only include attributes whose name starts with this prefix. */
+  prefix?: string
+}
+
+export interface AttributeIndexEntry {
+  /** Path of the file, relative to the root that was indexed. */
+  path: string
+  /** Name of the attribute. */
+  name: string
+  /** Value of the attribute. */
+  value: Buffer
+}
+
+export interface AttributeIndex {
+  /**
+   * Get the value of attribute `attr` on the file at `path`, relative to the indexed root.
+   *
+   * @returns the value of the attribute, or `undefined` if it isn't in the index.
+   */
+  get (path: string, attr: string): Buffer | undefined
+
+  /**
+   * List all indexed attributes on the file at `path`, relative to the indexed root.
+   */
+  list (path: string): string[]
+
+  /**
+   * Get all indexed attributes on files whose relative path starts with `prefix`, ordered by path and name.
+   */
+  scan (prefix: string): AttributeIndexEntry[]
+
+  /**
+   * Unmap the index file. Any further lookups will throw.
+   */
+  close (): void
+}
+
+/**
+ * Walk the tree at `root` and write a snapshot of its extended attributes to `outFile`. When `names` or `prefix` is given, only attributes matching either of them are included. A symbolic link as `root` is followed, entries that can't be read are skipped.
+ *
+ * @returns a `Promise` that will resolve when the index has been written.
+ */
+export function buildAttributeIndex (root: string, outFile: string, options?: AttributeIndexOptions): Promise<void>
+
+/**
+ * Synchronous version of `buildAttributeIndex`.
+ */
+export function buildAttributeIndexSync (root: string, outFile: string, options?: AttributeIndexOptions): void
+
+/**
+ * Memory-map an index written by `buildAttributeIndex`. Lookups are binary searches served from the mapping, without any system calls.
+ */
+export function openAttributeIndex (file: string): AttributeIndex
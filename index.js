@@ -2,6 +2,34 @@ import { createRequire } from 'node:module'
 
 const addon = createRequire(import.meta.url)('./build/Release/xattr')
 
+const encodings = ['buffer', 'utf8', 'latin1', 'uint64le', 'json']
+
+// Small enough to split values under per-value limits (Btrfs leaf size, XATTR_SIZE_MAX)
+const defaultChunkSize = 2048
+
+function isUint64 (val) {
+  if (typeof val === 'number') return Number.isSafeInteger(val) && val >= 0
+  if (typeof val === 'bigint') return val >= 0n && val <= 0xffffffffffffffffn
+  return false
+}
+
+function validateValue (val, encoding) {
+  switch (encodings[encoding]) {
+    case 'json':
+      return val
+    case 'utf8':
+    case 'latin1':
+      if (typeof val === 'string' || Buffer.isBuffer(val)) return val
+      throw new TypeError(`\`value\` must be a string or buffer when \`encoding\` is '${encodings[encoding]}'`)
+    case 'uint64le':
+      if (isUint64(val) || Buffer.isBuffer(val)) return val
+      throw new TypeError('`value` must be an unsigned 64-bit integer or buffer when `encoding` is \'uint64le\'')
+    default:
+      if (typeof val === 'string' || Buffer.isBuffer(val) || isUint64(val)) return val
+      throw new TypeError('`value` must be a string, buffer or unsigned 64-bit integer')
+  }
+}
+
 function validateArgument (key, val) {
   switch (key) {
     case 'path':
@@ -10,10 +38,35 @@ function validateArgument (key, val) {
     case 'attr':
       if (typeof val === 'string') return val
       throw new TypeError('`attr` must be a string')
-    case 'value':
-      if (typeof val === 'string') return Buffer.from(val)
-      if (Buffer.isBuffer(val)) return val
-      throw new TypeError('`value` must be a string or buffer')
+    case 'encoding':
+      if (val === undefined) return 0
+      if (encodings.includes(val)) return encodings.indexOf(val)
+      throw new TypeError(`\`encoding\` must be one of ${encodings.map(name => `'${name}'`).join(', ')}`)
+    case 'name':
+      if (typeof val === 'string' && val !== '' && !val.startsWith('/')) return val
+      throw new TypeError('`name` must be a non-empty relative path')
+    case 'chunked':
+    case 'compress':
+    case 'noFollow':
+      if (val === undefined) return false
+      if (typeof val === 'boolean') return val
+      throw new TypeError(`\`${key}\` must be a boolean`)
+    case 'chunkSize':
+      if (val === undefined) return defaultChunkSize
+      if (Number.isInteger(val) && val >= 64 && val <= 0xffffffff) return val
+      throw new TypeError('`chunkSize` must be an integer of at least 64')
+    case 'options':
+      if (val === undefined) return {}
+      if (typeof val === 'object' && val !== null) return val
+      throw new TypeError('`options` must be an object')
+    case 'names':
+      if (val === undefined) return null
+      if (Array.isArray(val) && val.every(name => typeof name === 'string')) return val
+      throw new TypeError('`names` must be an array of strings')
+    case 'prefix':
+      if (val === undefined) return null
+      if (typeof val === 'string') return val
+      throw new TypeError('`prefix` must be a string')
     default:
       throw new Error(`Unknown argument: ${key}`)
   }
@@ -21,19 +74,30 @@ function validateArgument (key, val) {
 
 /* Async methods */
 
-export function getAttribute (path, attr) {
+export function getAttribute (path, attr, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
+  options = validateArgument('options', options)
 
-  return addon.get(path, attr)
+  const encoding = validateArgument('encoding', options.encoding)
+  const chunked = validateArgument('chunked', options.chunked)
+
+  return addon.get(path, attr, encoding, chunked)
 }
 
-export function setAttribute (path, attr, value) {
+export function setAttribute (path, attr, value, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
-  value = validateArgument('value', value)
+  options = validateArgument('options', options)
+
+  const encoding = validateArgument('encoding', options.encoding)
+  value = validateValue(value, encoding)
 
-  return addon.set(path, attr, value)
+  const compress = validateArgument('compress', options.compress)
+  const chunked = validateArgument('chunked', options.chunked) || compress
+  const chunkSize = chunked ? validateArgument('chunkSize', options.chunkSize) : 0
+
+  return addon.set(path, attr, value, encoding, chunkSize, compress)
 }
 
 export function listAttributes (path) {
@@ -42,28 +106,42 @@ export function listAttributes (path) {
   return addon.list(path)
 }
 
-export function removeAttribute (path, attr) {
+export function removeAttribute (path, attr, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
+  options = validateArgument('options', options)
+
+  const chunked = validateArgument('chunked', options.chunked)
 
-  return addon.remove(path, attr)
+  return addon.remove(path, attr, chunked)
 }
 
 /* Sync methods */
 
-export function getAttributeSync (path, attr) {
+export function getAttributeSync (path, attr, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
+  options = validateArgument('options', options)
+
+  const encoding = validateArgument('encoding', options.encoding)
+  const chunked = validateArgument('chunked', options.chunked)
 
-  return addon.getSync(path, attr)
+  return addon.getSync(path, attr, encoding, chunked)
 }
 
-export function setAttributeSync (path, attr, value) {
+export function setAttributeSync (path, attr, value, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
-  value = validateArgument('value', value)
+  options = validateArgument('options', options)
 
-  return addon.setSync(path, attr, value)
+  const encoding = validateArgument('encoding', options.encoding)
+  value = validateValue(value, encoding)
+
+  const compress = validateArgument('compress', options.compress)
+  const chunked = validateArgument('chunked', options.chunked) || compress
+  const chunkSize = chunked ? validateArgument('chunkSize', options.chunkSize) : 0
+
+  return addon.setSync(path, attr, value, encoding, chunkSize, compress)
 }
 
 export function listAttributesSync (path) {
@@ -72,9 +150,173 @@ export function listAttributesSync (path) {
   return addon.listSync(path)
 }
 
-export function removeAttributeSync (path, attr) {
+export function removeAttributeSync (path, attr, options) {
   path = validateArgument('path', path)
   attr = validateArgument('attr', attr)
+  options = validateArgument('options', options)
+
+  const chunked = validateArgument('chunked', options.chunked)
+
+  return addon.removeSync(path, attr, chunked)
+}
+
+/* Directory handle */
+
+class AttributeDir {
+  constructor (handle) {
+    this._handle = handle
+  }
+
+  get (name, attr, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const encoding = validateArgument('encoding', options.encoding)
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirGet(this._handle, name, attr, null, encoding, noFollow)
+  }
+
+  getSync (name, attr, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const encoding = validateArgument('encoding', options.encoding)
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirGetSync(this._handle, name, attr, null, encoding, noFollow)
+  }
+
+  set (name, attr, value, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const encoding = validateArgument('encoding', options.encoding)
+    value = validateValue(value, encoding)
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirSet(this._handle, name, attr, value, encoding, noFollow)
+  }
+
+  setSync (name, attr, value, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const encoding = validateArgument('encoding', options.encoding)
+    value = validateValue(value, encoding)
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirSetSync(this._handle, name, attr, value, encoding, noFollow)
+  }
+
+  list (name, options) {
+    name = validateArgument('name', name)
+    options = validateArgument('options', options)
+
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirList(this._handle, name, null, null, 0, noFollow)
+  }
+
+  listSync (name, options) {
+    name = validateArgument('name', name)
+    options = validateArgument('options', options)
+
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirListSync(this._handle, name, null, null, 0, noFollow)
+  }
+
+  remove (name, attr, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirRemove(this._handle, name, attr, null, 0, noFollow)
+  }
+
+  removeSync (name, attr, options) {
+    name = validateArgument('name', name)
+    attr = validateArgument('attr', attr)
+    options = validateArgument('options', options)
+
+    const noFollow = validateArgument('noFollow', options.noFollow)
+
+    return addon.dirRemoveSync(this._handle, name, attr, null, 0, noFollow)
+  }
+
+  close () {
+    addon.dirClose(this._handle)
+  }
+}
+
+export function openAttributeDir (path) {
+  path = validateArgument('path', path)
+
+  return new AttributeDir(addon.openDir(path))
+}
+
+/* Attribute index */
+
+class AttributeIndex {
+  constructor (handle) {
+    this._handle = handle
+  }
+
+  get (path, attr) {
+    path = validateArgument('path', path)
+    attr = validateArgument('attr', attr)
+
+    return addon.indexGet(this._handle, path, attr)
+  }
+
+  list (path) {
+    path = validateArgument('path', path)
+
+    return addon.indexList(this._handle, path)
+  }
+
+  scan (prefix) {
+    prefix = validateArgument('path', prefix)
+
+    return addon.indexScan(this._handle, prefix)
+  }
+
+  close () {
+    addon.indexClose(this._handle)
+  }
+}
+
+export function buildAttributeIndex (root, outFile, options) {
+  root = validateArgument('path', root)
+  outFile = validateArgument('path', outFile)
+  options = validateArgument('options', options)
+
+  const names = validateArgument('names', options.names)
+  const prefix = validateArgument('prefix', options.prefix)
+
+  return addon.buildIndex(root, outFile, names, prefix)
+}
+
+export function buildAttributeIndexSync (root, outFile, options) {
+  root = validateArgument('path', root)
+  outFile = validateArgument('path', outFile)
+  options = validateArgument('options', options)
+
+  const names = validateArgument('names', options.names)
+  const prefix = validateArgument('prefix', options.prefix)
+
+  return addon.buildIndexSync(root, outFile, names, prefix)
+}
+
+export function openAttributeIndex (file) {
+  file = validateArgument('path', file)
 
-  return addon.removeSync(path, attr)
+  return new AttributeIndex(addon.openIndex(file))
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <sys/xattr.h>
 
+#include "chunked.h"
 #include "error.h"
 #include "util.h"
 
@@ -11,7 +12,10 @@
 typedef struct {
   char* filename;
   char* attribute;
+  xattr_encoding encoding;
+  bool chunked;
   napi_deferred deferred;
+  napi_async_work work;
   int e;
   ssize_t value_length;
   char* value;
@@ -20,6 +24,13 @@ typedef struct {
 void xattr_get_execute(napi_env env, void* _data) {
   XattrGetData* data = _data;
 
+  if (data->chunked) {
+    size_t value_length;
+    data->e = chunked_read(data->filename, data->attribute, &data->value, &value_length);
+    data->value_length = data->e == 0 ? (ssize_t) value_length : -1;
+    return ;
+  }
+
 #ifdef __APPLE__
   data->value_length = getxattr(data->filename, data->attribute, NULL, 0, 0, 0);
 #else
@@ -50,27 +61,36 @@ void xattr_get_complete(napi_env env, napi_status status, void* _data) {
 
   free(data->filename);
   free(data->attribute);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
+
+  napi_value result;
 
   if (data->value_length == -1) {
-    napi_value error;
-    assert(create_xattr_error(env, data->e, &error) == napi_ok);
-    assert(napi_reject_deferred(env, data->deferred, error) == napi_ok);
-    return;
+    assert(create_xattr_error(env, data->e, &result) == napi_ok);
+    assert(napi_reject_deferred(env, data->deferred, result) == napi_ok);
+  } else {
+    status = decode_value(env, data->encoding, data->value, (size_t) data->value_length, &result);
+
+    if (status == napi_pending_exception) {
+      assert(napi_get_and_clear_last_exception(env, &result) == napi_ok);
+      assert(napi_reject_deferred(env, data->deferred, result) == napi_ok);
+    } else {
+      assert(status == napi_ok);
+      assert(napi_resolve_deferred(env, data->deferred, result) == napi_ok);
+    }
   }
 
-  napi_value buffer;
-  assert(napi_create_buffer_copy(env, data->value_length, data->value, NULL, &buffer) == napi_ok);
-  assert(napi_resolve_deferred(env, data->deferred, buffer) == napi_ok);
-
+  free(data->value);
   free(_data);
 }
 
 napi_value xattr_get(napi_env env, napi_callback_info info) {
-  size_t argc = 2;
-  napi_value args[2];
+  size_t argc = 4;
+  napi_value args[4];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   XattrGetData* data = malloc(sizeof(XattrGetData));
+  data->value = NULL;
 
   size_t filename_length;
   assert(napi_get_value_string_utf8(env, args[0], NULL, 0, &filename_length) == napi_ok);
@@ -82,16 +102,18 @@ napi_value xattr_get(napi_env env, napi_callback_info info) {
   data->attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], data->attribute, attribute_length + 1, NULL) == napi_ok);
 
+  assert(get_encoding(env, args[2], &data->encoding) == napi_ok);
+  assert(napi_get_value_bool(env, args[3], &data->chunked) == napi_ok);
+
   napi_value promise;
   assert(napi_create_promise(env, &data->deferred, &promise) == napi_ok);
 
   napi_value work_name;
   assert(napi_create_string_utf8(env, "fs-xattr:get", NAPI_AUTO_LENGTH, &work_name) == napi_ok);
 
-  napi_async_work work;
-  assert(napi_create_async_work(env, NULL, work_name, xattr_get_execute, xattr_get_complete, (void*) data, &work) == napi_ok);
+  assert(napi_create_async_work(env, NULL, work_name, xattr_get_execute, xattr_get_complete, (void*) data, &data->work) == napi_ok);
 
-  assert(napi_queue_async_work(env, work) == napi_ok);
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
 
   return promise;
 }
@@ -100,14 +122,24 @@ typedef struct {
   char* filename;
   char* attribute;
   napi_deferred deferred;
+  napi_async_work work;
   int e;
-  ssize_t value_length;
+  size_t value_length;
   char* value;
+  int owns_value;
+  napi_ref value_ref;
+  uint32_t chunk_size;
+  bool compress;
 } XattrSetData;
 
 void xattr_set_execute(napi_env env, void* _data) {
   XattrSetData* data = _data;
 
+  if (data->chunk_size != 0) {
+    data->e = chunked_write(data->filename, data->attribute, data->value, data->value_length, data->chunk_size, data->compress);
+    return ;
+  }
+
 #ifdef __APPLE__
   int res = setxattr(data->filename, data->attribute, data->value, data->value_length, 0, 0);
 #else
@@ -126,28 +158,47 @@ void xattr_set_complete(napi_env env, napi_status status, void* _data) {
 
   free(data->filename);
   free(data->attribute);
+  if (data->owns_value) free(data->value);
+  if (data->value_ref != NULL) assert(napi_delete_reference(env, data->value_ref) == napi_ok);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
 
   if (data->e != 0) {
     napi_value error;
     assert(create_xattr_error(env, data->e, &error) == napi_ok);
     assert(napi_reject_deferred(env, data->deferred, error) == napi_ok);
-    return;
+  } else {
+    napi_value undefined;
+    assert(napi_get_undefined(env, &undefined) == napi_ok);
+    assert(napi_resolve_deferred(env, data->deferred, undefined) == napi_ok);
   }
 
-  napi_value undefined;
-  assert(napi_get_undefined(env, &undefined) == napi_ok);
-  assert(napi_resolve_deferred(env, data->deferred, undefined) == napi_ok);
-
   free(_data);
 }
 
 napi_value xattr_set(napi_env env, napi_callback_info info) {
-  size_t argc = 3;
-  napi_value args[3];
+  size_t argc = 6;
+  napi_value args[6];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
+  xattr_encoding encoding;
+  assert(get_encoding(env, args[3], &encoding) == napi_ok);
+
   XattrSetData* data = malloc(sizeof(XattrSetData));
 
+  napi_status status = encode_value(env, encoding, args[2], &data->value, &data->value_length, &data->owns_value);
+  if (status == napi_pending_exception) {
+    free(data);
+    return NULL;
+  }
+  assert(status == napi_ok);
+
+  /* A buffer value is used in place, so keep it alive until the work has completed */
+  data->value_ref = NULL;
+  if (!data->owns_value) assert(napi_create_reference(env, args[2], 1, &data->value_ref) == napi_ok);
+
+  assert(napi_get_value_uint32(env, args[4], &data->chunk_size) == napi_ok);
+  assert(napi_get_value_bool(env, args[5], &data->compress) == napi_ok);
+
   size_t filename_length;
   assert(napi_get_value_string_utf8(env, args[0], NULL, 0, &filename_length) == napi_ok);
   data->filename = malloc(filename_length + 1);
@@ -158,18 +209,15 @@ napi_value xattr_set(napi_env env, napi_callback_info info) {
   data->attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], data->attribute, attribute_length + 1, NULL) == napi_ok);
 
-  assert(napi_get_buffer_info(env, args[2], (void**) &data->value, (size_t*) &data->value_length) == napi_ok);
-
   napi_value promise;
   assert(napi_create_promise(env, &data->deferred, &promise) == napi_ok);
 
   napi_value work_name;
   assert(napi_create_string_utf8(env, "fs-xattr:set", NAPI_AUTO_LENGTH, &work_name) == napi_ok);
 
-  napi_async_work work;
-  assert(napi_create_async_work(env, NULL, work_name, xattr_set_execute, xattr_set_complete, (void*) data, &work) == napi_ok);
+  assert(napi_create_async_work(env, NULL, work_name, xattr_set_execute, xattr_set_complete, (void*) data, &data->work) == napi_ok);
 
-  assert(napi_queue_async_work(env, work) == napi_ok);
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
 
   return promise;
 }
@@ -177,6 +225,7 @@ napi_value xattr_set(napi_env env, napi_callback_info info) {
 typedef struct {
   char* filename;
   napi_deferred deferred;
+  napi_async_work work;
   int e;
   ssize_t result_length;
   char* result;
@@ -214,18 +263,18 @@ void xattr_list_complete(napi_env env, napi_status status, void* _data) {
   XattrListData* data = _data;
 
   free(data->filename);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
 
   if (data->result_length == -1) {
     napi_value error;
     assert(create_xattr_error(env, data->e, &error) == napi_ok);
     assert(napi_reject_deferred(env, data->deferred, error) == napi_ok);
-    return;
+  } else {
+    napi_value array;
+    assert(split_string_array(env, data->result, (size_t) data->result_length, &array) == napi_ok);
+    assert(napi_resolve_deferred(env, data->deferred, array) == napi_ok);
   }
 
-  napi_value array;
-  assert(split_string_array(env, data->result, (size_t) data->result_length, &array) == napi_ok);
-  assert(napi_resolve_deferred(env, data->deferred, array) == napi_ok);
-
   free(data->result);
   free(_data);
 }
@@ -236,6 +285,7 @@ napi_value xattr_list(napi_env env, napi_callback_info info) {
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   XattrListData* data = malloc(sizeof(XattrListData));
+  data->result = NULL;
 
   size_t filename_length;
   assert(napi_get_value_string_utf8(env, args[0], NULL, 0, &filename_length) == napi_ok);
@@ -248,10 +298,9 @@ napi_value xattr_list(napi_env env, napi_callback_info info) {
   napi_value work_name;
   assert(napi_create_string_utf8(env, "fs-xattr:list", NAPI_AUTO_LENGTH, &work_name) == napi_ok);
 
-  napi_async_work work;
-  assert(napi_create_async_work(env, NULL, work_name, xattr_list_execute, xattr_list_complete, (void*) data, &work) == napi_ok);
+  assert(napi_create_async_work(env, NULL, work_name, xattr_list_execute, xattr_list_complete, (void*) data, &data->work) == napi_ok);
 
-  assert(napi_queue_async_work(env, work) == napi_ok);
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
 
   return promise;
 }
@@ -259,13 +308,20 @@ napi_value xattr_list(napi_env env, napi_callback_info info) {
 typedef struct {
   char* filename;
   char* attribute;
+  bool chunked;
   napi_deferred deferred;
+  napi_async_work work;
   int e;
 } XattrRemoveData;
 
 void xattr_remove_execute(napi_env env, void* _data) {
   XattrRemoveData* data = _data;
 
+  if (data->chunked) {
+    data->e = chunked_remove(data->filename, data->attribute);
+    return ;
+  }
+
 #ifdef __APPLE__
   int res = removexattr(data->filename, data->attribute, 0);
 #else
@@ -284,24 +340,24 @@ void xattr_remove_complete(napi_env env, napi_status status, void* _data) {
 
   free(data->filename);
   free(data->attribute);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
 
   if (data->e != 0) {
     napi_value error;
     assert(create_xattr_error(env, data->e, &error) == napi_ok);
     assert(napi_reject_deferred(env, data->deferred, error) == napi_ok);
-    return;
+  } else {
+    napi_value undefined;
+    assert(napi_get_undefined(env, &undefined) == napi_ok);
+    assert(napi_resolve_deferred(env, data->deferred, undefined) == napi_ok);
   }
 
-  napi_value undefined;
-  assert(napi_get_undefined(env, &undefined) == napi_ok);
-  assert(napi_resolve_deferred(env, data->deferred, undefined) == napi_ok);
-
   free(_data);
 }
 
 napi_value xattr_remove(napi_env env, napi_callback_info info) {
-  size_t argc = 2;
-  napi_value args[2];
+  size_t argc = 3;
+  napi_value args[3];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   XattrRemoveData* data = malloc(sizeof(XattrRemoveData));
@@ -316,16 +372,17 @@ napi_value xattr_remove(napi_env env, napi_callback_info info) {
   data->attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], data->attribute, attribute_length + 1, NULL) == napi_ok);
 
+  assert(napi_get_value_bool(env, args[2], &data->chunked) == napi_ok);
+
   napi_value promise;
   assert(napi_create_promise(env, &data->deferred, &promise) == napi_ok);
 
   napi_value work_name;
   assert(napi_create_string_utf8(env, "fs-xattr:remove", NAPI_AUTO_LENGTH, &work_name) == napi_ok);
 
-  napi_async_work work;
-  assert(napi_create_async_work(env, NULL, work_name, xattr_remove_execute, xattr_remove_complete, (void*) data, &work) == napi_ok);
+  assert(napi_create_async_work(env, NULL, work_name, xattr_remove_execute, xattr_remove_complete, (void*) data, &data->work) == napi_ok);
 
-  assert(napi_queue_async_work(env, work) == napi_ok);
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
 
   return promise;
 }
@@ -1,7 +1,7 @@
 #ifndef LD_ASYNC_H
 #define LD_ASYNC_H
 
-#define NAPI_VERSION 1
+#define NAPI_VERSION 6
 #include <node_api.h>
 
 napi_value xattr_get(napi_env env, napi_callback_info info);
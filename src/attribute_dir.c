@@ -0,0 +1,437 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "instance.h"
+#include "util.h"
+
+#include "attribute_dir.h"
+
+/*
+ * Entries are resolved relative to an open directory fd instead of walking
+ * their full path from `/` on every call. On Linux this goes through
+ * `/proc/self/fd/<fd>/<name>`, which works with both the following and the
+ * `l*xattr` calls and needs no extra open/close. Elsewhere, or when /proc
+ * isn't mounted, the entry is opened with `openat` and the `f*xattr` calls
+ * are used instead. Linux can't open a symbolic link itself, so without /proc
+ * `noFollow` falls back to the full path.
+ */
+
+typedef struct {
+  XattrResource resource;
+  int fd;
+  char* path;
+  bool use_proc;
+  bool closed;
+  uint32_t pending;
+} AttributeDir;
+
+typedef struct {
+  int fd;
+  char* path;
+  bool no_follow;
+} DirTarget;
+
+static int dir_target_open(const AttributeDir* dir, const char* name, bool no_follow, DirTarget* target) {
+  target->fd = -1;
+  target->path = NULL;
+  target->no_follow = no_follow;
+
+  if (dir->use_proc) {
+    size_t length = strlen(name) + 32;
+    target->path = malloc(length);
+    snprintf(target->path, length, "/proc/self/fd/%d/%s", dir->fd, name);
+    return 0;
+  }
+
+#ifndef O_SYMLINK
+  if (no_follow) {
+    size_t length = strlen(dir->path) + strlen(name) + 2;
+    target->path = malloc(length);
+    snprintf(target->path, length, "%s/%s", dir->path, name);
+    return 0;
+  }
+#endif
+
+  int flags = O_RDONLY | O_NONBLOCK | O_CLOEXEC;
+#ifdef O_SYMLINK
+  if (no_follow) flags |= O_SYMLINK;
+#endif
+
+  target->fd = openat(dir->fd, name, flags);
+  if (target->fd == -1) return errno;
+
+  return 0;
+}
+
+static void dir_target_close(DirTarget* target) {
+  if (target->fd != -1) close(target->fd);
+  free(target->path);
+}
+
+static ssize_t dir_target_get(const DirTarget* target, const char* attribute, void* value, size_t size) {
+#ifdef __APPLE__
+  return fgetxattr(target->fd, attribute, value, size, 0, 0);
+#else
+  if (target->fd != -1) return fgetxattr(target->fd, attribute, value, size);
+  if (target->no_follow) return lgetxattr(target->path, attribute, value, size);
+  return getxattr(target->path, attribute, value, size);
+#endif
+}
+
+static int dir_target_set(const DirTarget* target, const char* attribute, const void* value, size_t size) {
+#ifdef __APPLE__
+  return fsetxattr(target->fd, attribute, value, size, 0, 0);
+#else
+  if (target->fd != -1) return fsetxattr(target->fd, attribute, value, size, 0);
+  if (target->no_follow) return lsetxattr(target->path, attribute, value, size, 0);
+  return setxattr(target->path, attribute, value, size, 0);
+#endif
+}
+
+static ssize_t dir_target_list(const DirTarget* target, char* result, size_t size) {
+#ifdef __APPLE__
+  return flistxattr(target->fd, result, size, 0);
+#else
+  if (target->fd != -1) return flistxattr(target->fd, result, size);
+  if (target->no_follow) return llistxattr(target->path, result, size);
+  return listxattr(target->path, result, size);
+#endif
+}
+
+static int dir_target_remove(const DirTarget* target, const char* attribute) {
+#ifdef __APPLE__
+  return fremovexattr(target->fd, attribute, 0);
+#else
+  if (target->fd != -1) return fremovexattr(target->fd, attribute);
+  if (target->no_follow) return lremovexattr(target->path, attribute);
+  return removexattr(target->path, attribute);
+#endif
+}
+
+typedef enum {
+  DIR_OP_GET,
+  DIR_OP_SET,
+  DIR_OP_LIST,
+  DIR_OP_REMOVE
+} DirOp;
+
+typedef struct {
+  DirOp op;
+  AttributeDir* dir;
+  napi_ref dir_ref;
+  char* name;
+  char* attribute;
+  bool no_follow;
+  xattr_encoding encoding;
+  char* value;
+  size_t value_length;
+  int owns_value;
+  napi_ref value_ref;
+  napi_deferred deferred;
+  napi_async_work work;
+  int e;
+} XattrDirData;
+
+static int dir_run(XattrDirData* data) {
+  DirTarget target;
+  int e = dir_target_open(data->dir, data->name, data->no_follow, &target);
+  if (e != 0) return e;
+
+  ssize_t length;
+
+  switch (data->op) {
+    case DIR_OP_GET:
+    case DIR_OP_LIST:
+      length = data->op == DIR_OP_GET ? dir_target_get(&target, data->attribute, NULL, 0) : dir_target_list(&target, NULL, 0);
+      if (length == -1) {
+        e = errno;
+        break;
+      }
+
+      data->value = malloc((size_t) length + 1);
+      data->owns_value = 1;
+
+      length = data->op == DIR_OP_GET ? dir_target_get(&target, data->attribute, data->value, (size_t) length) : dir_target_list(&target, data->value, (size_t) length);
+      if (length == -1) {
+        e = errno;
+        break;
+      }
+
+      data->value_length = (size_t) length;
+      break;
+    case DIR_OP_SET:
+      if (dir_target_set(&target, data->attribute, data->value, data->value_length) == -1) e = errno;
+      break;
+    case DIR_OP_REMOVE:
+      if (dir_target_remove(&target, data->attribute) == -1) e = errno;
+      break;
+  }
+
+  dir_target_close(&target);
+  return e;
+}
+
+static napi_status dir_result(napi_env env, XattrDirData* data, napi_value* result) {
+  switch (data->op) {
+    case DIR_OP_GET:
+      return decode_value(env, data->encoding, data->value, data->value_length, result);
+    case DIR_OP_LIST:
+      return split_string_array(env, data->value, data->value_length, result);
+    default:
+      return napi_get_undefined(env, result);
+  }
+}
+
+static void dir_data_free(XattrDirData* data) {
+  free(data->name);
+  free(data->attribute);
+  if (data->owns_value) free(data->value);
+  free(data);
+}
+
+static void dir_release(AttributeDir* dir) {
+  if (dir->pending == 0 && dir->closed && dir->fd != -1) {
+    close(dir->fd);
+    dir->fd = -1;
+  }
+}
+
+static void dir_close(XattrResource* resource) {
+  AttributeDir* dir = (AttributeDir*) resource;
+
+  dir->closed = true;
+  dir_release(dir);
+}
+
+static void dir_finalize(napi_env env, void* _data, void* hint) {
+  AttributeDir* dir = _data;
+
+  instance_untrack(&dir->resource);
+
+  if (dir->fd != -1) close(dir->fd);
+  free(dir->path);
+  free(dir);
+}
+
+static char* dir_get_string(napi_env env, napi_value value) {
+  size_t length;
+  assert(napi_get_value_string_utf8(env, value, NULL, 0, &length) == napi_ok);
+  char* string = malloc(length + 1);
+  assert(napi_get_value_string_utf8(env, value, string, length + 1, NULL) == napi_ok);
+  return string;
+}
+
+/* Arguments are always (handle, name, attr, value, encoding, noFollow), with unused ones set to null */
+static XattrDirData* dir_data_from_args(napi_env env, napi_callback_info info, DirOp op) {
+  size_t argc = 6;
+  napi_value args[6];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeDir* dir;
+  assert(napi_get_value_external(env, args[0], (void**) &dir) == napi_ok);
+
+  if (dir->closed) {
+    assert(napi_throw_error(env, NULL, "The attribute directory has been closed") == napi_ok);
+    return NULL;
+  }
+
+  XattrDirData* data = calloc(1, sizeof(XattrDirData));
+  data->op = op;
+  data->dir = dir;
+
+  assert(get_encoding(env, args[4], &data->encoding) == napi_ok);
+  assert(napi_get_value_bool(env, args[5], &data->no_follow) == napi_ok);
+
+  if (op == DIR_OP_SET) {
+    napi_status status = encode_value(env, data->encoding, args[3], &data->value, &data->value_length, &data->owns_value);
+    if (status == napi_pending_exception) {
+      free(data);
+      return NULL;
+    }
+    assert(status == napi_ok);
+
+    /* A buffer value is used in place, so keep it alive until the operation has completed */
+    if (!data->owns_value) assert(napi_create_reference(env, args[3], 1, &data->value_ref) == napi_ok);
+  }
+
+  data->name = dir_get_string(env, args[1]);
+  if (op != DIR_OP_LIST) data->attribute = dir_get_string(env, args[2]);
+
+  /* Keep the handle alive, and its fd open, until the operation has completed */
+  assert(napi_create_reference(env, args[0], 1, &data->dir_ref) == napi_ok);
+  dir->pending += 1;
+
+  return data;
+}
+
+static void dir_data_done(napi_env env, XattrDirData* data) {
+  data->dir->pending -= 1;
+  dir_release(data->dir);
+  assert(napi_delete_reference(env, data->dir_ref) == napi_ok);
+  if (data->value_ref != NULL) assert(napi_delete_reference(env, data->value_ref) == napi_ok);
+}
+
+static napi_value dir_call_sync(napi_env env, napi_callback_info info, DirOp op) {
+  XattrDirData* data = dir_data_from_args(env, info, op);
+  if (data == NULL) return NULL;
+
+  int e = dir_run(data);
+  dir_data_done(env, data);
+
+  if (e != 0) {
+    dir_data_free(data);
+    assert(throw_xattr_error(env, e) == napi_ok);
+    return NULL;
+  }
+
+  napi_value result;
+  napi_status status = dir_result(env, data, &result);
+  dir_data_free(data);
+
+  if (status == napi_pending_exception) return NULL;
+  assert(status == napi_ok);
+
+  return result;
+}
+
+void xattr_dir_execute(napi_env env, void* _data) {
+  XattrDirData* data = _data;
+
+  data->e = dir_run(data);
+}
+
+void xattr_dir_complete(napi_env env, napi_status status, void* _data) {
+  XattrDirData* data = _data;
+
+  dir_data_done(env, data);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
+
+  napi_value result;
+
+  if (data->e != 0) {
+    assert(create_xattr_error(env, data->e, &result) == napi_ok);
+    assert(napi_reject_deferred(env, data->deferred, result) == napi_ok);
+    dir_data_free(data);
+    return;
+  }
+
+  status = dir_result(env, data, &result);
+
+  if (status == napi_pending_exception) {
+    assert(napi_get_and_clear_last_exception(env, &result) == napi_ok);
+    assert(napi_reject_deferred(env, data->deferred, result) == napi_ok);
+  } else {
+    assert(status == napi_ok);
+    assert(napi_resolve_deferred(env, data->deferred, result) == napi_ok);
+  }
+
+  dir_data_free(data);
+}
+
+static napi_value dir_call(napi_env env, napi_callback_info info, DirOp op, const char* name) {
+  XattrDirData* data = dir_data_from_args(env, info, op);
+  if (data == NULL) return NULL;
+
+  napi_value promise;
+  assert(napi_create_promise(env, &data->deferred, &promise) == napi_ok);
+
+  napi_value work_name;
+  assert(napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &work_name) == napi_ok);
+
+  assert(napi_create_async_work(env, NULL, work_name, xattr_dir_execute, xattr_dir_complete, (void*) data, &data->work) == napi_ok);
+
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
+
+  return promise;
+}
+
+napi_value xattr_open_dir(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeDir* dir = malloc(sizeof(AttributeDir));
+  dir->path = dir_get_string(env, args[0]);
+  dir->use_proc = false;
+  dir->closed = false;
+  dir->pending = 0;
+
+  int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+#ifdef __linux__
+  dir->use_proc = access("/proc/self/fd", X_OK) == 0;
+#ifdef O_PATH
+  if (dir->use_proc) flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#endif
+#endif
+
+  dir->fd = open(dir->path, flags);
+
+  if (dir->fd == -1) {
+    int e = errno;
+    free(dir->path);
+    free(dir);
+    assert(throw_xattr_error(env, e) == napi_ok);
+    return NULL;
+  }
+
+  instance_track(env, &dir->resource, dir_close);
+
+  napi_value result;
+  assert(napi_create_external(env, dir, dir_finalize, NULL, &result) == napi_ok);
+
+  return result;
+}
+
+napi_value xattr_dir_get(napi_env env, napi_callback_info info) {
+  return dir_call(env, info, DIR_OP_GET, "fs-xattr:dirGet");
+}
+
+napi_value xattr_dir_get_sync(napi_env env, napi_callback_info info) {
+  return dir_call_sync(env, info, DIR_OP_GET);
+}
+
+napi_value xattr_dir_set(napi_env env, napi_callback_info info) {
+  return dir_call(env, info, DIR_OP_SET, "fs-xattr:dirSet");
+}
+
+napi_value xattr_dir_set_sync(napi_env env, napi_callback_info info) {
+  return dir_call_sync(env, info, DIR_OP_SET);
+}
+
+napi_value xattr_dir_list(napi_env env, napi_callback_info info) {
+  return dir_call(env, info, DIR_OP_LIST, "fs-xattr:dirList");
+}
+
+napi_value xattr_dir_list_sync(napi_env env, napi_callback_info info) {
+  return dir_call_sync(env, info, DIR_OP_LIST);
+}
+
+napi_value xattr_dir_remove(napi_env env, napi_callback_info info) {
+  return dir_call(env, info, DIR_OP_REMOVE, "fs-xattr:dirRemove");
+}
+
+napi_value xattr_dir_remove_sync(napi_env env, napi_callback_info info) {
+  return dir_call_sync(env, info, DIR_OP_REMOVE);
+}
+
+napi_value xattr_dir_close(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeDir* dir;
+  assert(napi_get_value_external(env, args[0], (void**) &dir) == napi_ok);
+
+  instance_untrack(&dir->resource);
+  dir_close(&dir->resource);
+
+  return NULL;
+}
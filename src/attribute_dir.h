@@ -0,0 +1,18 @@
+#ifndef LD_ATTRIBUTE_DIR_H
+#define LD_ATTRIBUTE_DIR_H
+
+#define NAPI_VERSION 6
+#include <node_api.h>
+
+napi_value xattr_open_dir(napi_env env, napi_callback_info info);
+napi_value xattr_dir_get(napi_env env, napi_callback_info info);
+napi_value xattr_dir_get_sync(napi_env env, napi_callback_info info);
+napi_value xattr_dir_set(napi_env env, napi_callback_info info);
+napi_value xattr_dir_set_sync(napi_env env, napi_callback_info info);
+napi_value xattr_dir_list(napi_env env, napi_callback_info info);
+napi_value xattr_dir_list_sync(napi_env env, napi_callback_info info);
+napi_value xattr_dir_remove(napi_env env, napi_callback_info info);
+napi_value xattr_dir_remove_sync(napi_env env, napi_callback_info info);
+napi_value xattr_dir_close(napi_env env, napi_callback_info info);
+
+#endif
@@ -0,0 +1,854 @@
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "instance.h"
+#include "shared.h"
+
+#include "attribute_index.h"
+
+#ifdef __APPLE__
+#define E_ENOATTR ENOATTR
+#else
+#define E_ENOATTR ENODATA
+#endif
+
+/*
+ * On-disk layout (native byte order):
+ *
+ *   IndexHeader
+ *   IndexEntry[entry_count], sorted by (path, name)
+ *   string and value data referenced by the entries
+ *
+ * Paths are relative to the root that was scanned, with the root itself being
+ * the empty string. Consecutive entries for the same path share its bytes.
+ */
+
+#define INDEX_MAGIC "XATTRIDX"
+#define INDEX_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t entry_count;
+} IndexHeader;
+
+typedef struct {
+  uint64_t path_offset;
+  uint64_t name_offset;
+  uint64_t value_offset;
+  uint32_t path_length;
+  uint32_t name_length;
+  uint32_t value_length;
+  uint32_t reserved;
+} IndexEntry;
+
+static int index_compare(const char* a, size_t a_length, const char* b, size_t b_length) {
+  size_t length = a_length < b_length ? a_length : b_length;
+  int res = length == 0 ? 0 : memcmp(a, b, length);
+  if (res != 0) return res;
+  return (a_length > b_length) - (a_length < b_length);
+}
+
+static char* index_get_string(napi_env env, napi_value value, size_t* length) {
+  size_t string_length;
+  assert(napi_get_value_string_utf8(env, value, NULL, 0, &string_length) == napi_ok);
+  char* string = malloc(string_length + 1);
+  assert(napi_get_value_string_utf8(env, value, string, string_length + 1, NULL) == napi_ok);
+  if (length != NULL) *length = string_length;
+  return string;
+}
+
+/* Building */
+
+typedef struct {
+  char** names;
+  uint32_t names_count;
+  char* prefix;
+} IndexFilter;
+
+typedef struct {
+  char* path;
+  size_t path_length;
+  int owns_path;
+  char* name;
+  size_t name_length;
+  char* value;
+  size_t value_length;
+} IndexRecord;
+
+typedef struct {
+  const IndexFilter* filter;
+  IndexRecord* records;
+  size_t count;
+  size_t capacity;
+  char* path;
+  size_t path_length;
+  size_t path_capacity;
+  size_t relative_offset;
+} IndexBuilder;
+
+static void index_filter_from_args(napi_env env, napi_value names, napi_value prefix, IndexFilter* filter) {
+  napi_valuetype type;
+
+  filter->names = NULL;
+  filter->names_count = 0;
+  filter->prefix = NULL;
+
+  assert(napi_typeof(env, names, &type) == napi_ok);
+  if (type == napi_object) {
+    assert(napi_get_array_length(env, names, &filter->names_count) == napi_ok);
+    filter->names = malloc(sizeof(char*) * (filter->names_count + 1));
+
+    for (uint32_t i = 0; i < filter->names_count; i++) {
+      napi_value name;
+      assert(napi_get_element(env, names, i, &name) == napi_ok);
+      filter->names[i] = index_get_string(env, name, NULL);
+    }
+  }
+
+  assert(napi_typeof(env, prefix, &type) == napi_ok);
+  if (type == napi_string) {
+    filter->prefix = index_get_string(env, prefix, NULL);
+  }
+}
+
+static void index_filter_free(IndexFilter* filter) {
+  for (uint32_t i = 0; i < filter->names_count; i++) free(filter->names[i]);
+  free(filter->names);
+  free(filter->prefix);
+}
+
+static int index_filter_matches(const IndexFilter* filter, const char* name) {
+  if (filter->names == NULL && filter->prefix == NULL) return 1;
+
+  for (uint32_t i = 0; i < filter->names_count; i++) {
+    if (strcmp(filter->names[i], name) == 0) return 1;
+  }
+
+  if (filter->prefix != NULL && strncmp(name, filter->prefix, strlen(filter->prefix)) == 0) return 1;
+
+  return 0;
+}
+
+static ssize_t index_listxattr(const char* path, char* result, size_t size) {
+#ifdef __APPLE__
+  return listxattr(path, result, size, XATTR_NOFOLLOW);
+#else
+  return llistxattr(path, result, size);
+#endif
+}
+
+static ssize_t index_getxattr(const char* path, const char* name, char* value, size_t size) {
+#ifdef __APPLE__
+  return getxattr(path, name, value, size, 0, XATTR_NOFOLLOW);
+#else
+  return lgetxattr(path, name, value, size);
+#endif
+}
+
+static int index_read_list(const char* path, char** result, size_t* result_length) {
+  for (;;) {
+    ssize_t length = index_listxattr(path, NULL, 0);
+    if (length == -1) return errno;
+
+    if (length == 0) {
+      *result = NULL;
+      *result_length = 0;
+      return 0;
+    }
+
+    char* list = malloc((size_t) length);
+    if (list == NULL) return ENOMEM;
+
+    length = index_listxattr(path, list, (size_t) length);
+
+    if (length == -1) {
+      int e = errno;
+      free(list);
+      if (e == ERANGE) continue;
+      return e;
+    }
+
+    *result = list;
+    *result_length = (size_t) length;
+    return 0;
+  }
+}
+
+static int index_read_value(const char* path, const char* name, char** result, size_t* result_length) {
+  for (;;) {
+    ssize_t length = index_getxattr(path, name, NULL, 0);
+    if (length == -1) return errno;
+
+    if (length == 0) {
+      *result = NULL;
+      *result_length = 0;
+      return 0;
+    }
+
+    char* value = malloc((size_t) length);
+    if (value == NULL) return ENOMEM;
+
+    length = index_getxattr(path, name, value, (size_t) length);
+
+    if (length == -1) {
+      int e = errno;
+      free(value);
+      if (e == ERANGE) continue;
+      return e;
+    }
+
+    *result = value;
+    *result_length = (size_t) length;
+    return 0;
+  }
+}
+
+static int index_builder_push(IndexBuilder* builder, const IndexRecord* record) {
+  if (builder->count == builder->capacity) {
+    size_t capacity = builder->capacity == 0 ? 64 : builder->capacity * 2;
+    IndexRecord* records = realloc(builder->records, sizeof(IndexRecord) * capacity);
+    if (records == NULL) return ENOMEM;
+
+    builder->records = records;
+    builder->capacity = capacity;
+  }
+
+  builder->records[builder->count++] = *record;
+  return 0;
+}
+
+static int index_builder_collect(IndexBuilder* builder) {
+  char* list;
+  size_t list_length;
+
+  /* Entries that vanished, can't be read or don't support attributes are skipped rather than failing the whole build */
+  int e = index_read_list(builder->path, &list, &list_length);
+  if (e == ENOENT || e == ENOTSUP || e == EACCES || e == EPERM) return 0;
+  if (e != 0) return e;
+
+  const char* relative = builder->path + builder->relative_offset;
+  size_t relative_length = builder->path_length > builder->relative_offset ? builder->path_length - builder->relative_offset : 0;
+  char* shared_path = NULL;
+
+  size_t position = 0;
+  while (position < list_length) {
+    const char* name = list + position;
+    size_t name_length = strlen(name);
+    position += name_length + 1;
+
+    if (!index_filter_matches(builder->filter, name)) continue;
+
+    IndexRecord record;
+    e = index_read_value(builder->path, name, &record.value, &record.value_length);
+    if (e == E_ENOATTR || e == ENOENT || e == EACCES || e == EPERM) {
+      e = 0;
+      continue;
+    }
+    if (e != 0) break;
+
+    record.owns_path = shared_path == NULL;
+    if (shared_path == NULL) {
+      shared_path = malloc(relative_length + 1);
+      memcpy(shared_path, relative_length == 0 ? "" : relative, relative_length + 1);
+    }
+
+    record.path = shared_path;
+    record.path_length = relative_length;
+    record.name = malloc(name_length + 1);
+    memcpy(record.name, name, name_length + 1);
+    record.name_length = name_length;
+
+    e = index_builder_push(builder, &record);
+    if (e != 0) {
+      if (record.owns_path) free(record.path);
+      free(record.name);
+      free(record.value);
+      break;
+    }
+  }
+
+  free(list);
+  return e;
+}
+
+static int index_builder_push_path(IndexBuilder* builder, const char* name) {
+  size_t name_length = strlen(name);
+  int separator = builder->path_length > 0 && builder->path[builder->path_length - 1] != '/';
+  size_t length = builder->path_length + (size_t) separator + name_length;
+
+  if (length + 1 > builder->path_capacity) {
+    size_t capacity = (length + 1) * 2;
+    char* path = realloc(builder->path, capacity);
+    if (path == NULL) return ENOMEM;
+
+    builder->path = path;
+    builder->path_capacity = capacity;
+  }
+
+  if (separator) builder->path[builder->path_length] = '/';
+  memcpy(builder->path + builder->path_length + separator, name, name_length + 1);
+  builder->path_length = length;
+
+  return 0;
+}
+
+static int index_builder_walk(IndexBuilder* builder, int is_directory) {
+  int e = index_builder_collect(builder);
+  if (e != 0 || !is_directory) return e;
+
+  DIR* dir = opendir(builder->path);
+  if (dir == NULL) return errno == ENOENT || errno == EACCES || errno == EPERM ? 0 : errno;
+
+  size_t parent_length = builder->path_length;
+
+  for (;;) {
+    errno = 0;
+    struct dirent* entry = readdir(dir);
+
+    if (entry == NULL) {
+      e = errno;
+      break;
+    }
+
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+    e = index_builder_push_path(builder, entry->d_name);
+    if (e != 0) break;
+
+    int child_is_directory = entry->d_type == DT_DIR;
+
+    if (entry->d_type == DT_UNKNOWN) {
+      struct stat st;
+      if (lstat(builder->path, &st) == -1) {
+        e = errno == ENOENT || errno == EACCES || errno == EPERM ? 0 : errno;
+      } else {
+        child_is_directory = S_ISDIR(st.st_mode);
+        e = index_builder_walk(builder, child_is_directory);
+      }
+    } else {
+      e = index_builder_walk(builder, child_is_directory);
+    }
+
+    builder->path_length = parent_length;
+    builder->path[parent_length] = '\0';
+
+    if (e != 0) break;
+  }
+
+  closedir(dir);
+  return e;
+}
+
+static int index_record_compare(const void* _a, const void* _b) {
+  const IndexRecord* a = _a;
+  const IndexRecord* b = _b;
+
+  int res = index_compare(a->path, a->path_length, b->path, b->path_length);
+  if (res != 0) return res;
+
+  return index_compare(a->name, a->name_length, b->name, b->name_length);
+}
+
+static int index_fwrite(const void* data, size_t length, FILE* file) {
+  if (length == 0) return 0;
+  return fwrite(data, 1, length, file) == length ? 0 : errno;
+}
+
+/*
+ * Creates a unique sibling of `out_file`. Unlike mkstemp, the file is created
+ * with mode 0666 so that the process umask applies, as for any other file.
+ */
+static int index_open_temp(const char* out_file, char** result) {
+  static uint32_t counter = 0;
+
+  size_t length = strlen(out_file) + sizeof(".12345678");
+  char* temp_file = malloc(length);
+
+  for (;;) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uint32_t suffix = (uint32_t) now.tv_nsec ^ ((uint32_t) getpid() << 16) ^ (__atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED) * 2654435761u);
+    snprintf(temp_file, length, "%s.%08x", out_file, suffix);
+
+    int fd = open(temp_file, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0666);
+    if (fd != -1) {
+      *result = temp_file;
+      return fd;
+    }
+
+    if (errno != EEXIST) {
+      int e = errno;
+      free(temp_file);
+      errno = e;
+      return -1;
+    }
+  }
+}
+
+static int index_builder_write(const IndexBuilder* builder, const char* out_file) {
+  IndexEntry* entries = calloc(builder->count + 1, sizeof(IndexEntry));
+  if (entries == NULL) return ENOMEM;
+
+  uint64_t cursor = sizeof(IndexHeader) + sizeof(IndexEntry) * builder->count;
+  uint64_t path_offset = 0;
+
+  for (size_t i = 0; i < builder->count; i++) {
+    const IndexRecord* record = &builder->records[i];
+
+    if (i == 0 || index_compare(record->path, record->path_length, builder->records[i - 1].path, builder->records[i - 1].path_length) != 0) {
+      path_offset = cursor;
+      cursor += record->path_length;
+    }
+
+    if (record->value_length > UINT32_MAX) {
+      free(entries);
+      return E2BIG;
+    }
+
+    entries[i].path_offset = path_offset;
+    entries[i].path_length = (uint32_t) record->path_length;
+    entries[i].name_offset = cursor;
+    entries[i].name_length = (uint32_t) record->name_length;
+    cursor += record->name_length;
+    entries[i].value_offset = cursor;
+    entries[i].value_length = (uint32_t) record->value_length;
+    cursor += record->value_length;
+  }
+
+  IndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+  header.version = INDEX_VERSION;
+  header.entry_count = builder->count;
+
+  /* Write to a unique sibling file first, so readers never observe a partial index and concurrent builds don't clash */
+  char* temp_file = NULL;
+  int fd = index_open_temp(out_file, &temp_file);
+  FILE* file = fd == -1 ? NULL : fdopen(fd, "wb");
+  if (file == NULL) {
+    int e = errno;
+    if (fd != -1) {
+      close(fd);
+      unlink(temp_file);
+    }
+    free(temp_file);
+    free(entries);
+    return e;
+  }
+
+  int e = index_fwrite(&header, sizeof(header), file);
+  if (e == 0) e = index_fwrite(entries, sizeof(IndexEntry) * builder->count, file);
+
+  for (size_t i = 0; e == 0 && i < builder->count; i++) {
+    const IndexRecord* record = &builder->records[i];
+
+    if (i == 0 || entries[i].path_offset != entries[i - 1].path_offset) {
+      e = index_fwrite(record->path, record->path_length, file);
+    }
+
+    if (e == 0) e = index_fwrite(record->name, record->name_length, file);
+    if (e == 0) e = index_fwrite(record->value, record->value_length, file);
+  }
+
+  if (fclose(file) != 0 && e == 0) e = errno;
+  if (e == 0 && rename(temp_file, out_file) == -1) e = errno;
+  if (e != 0) unlink(temp_file);
+
+  free(temp_file);
+  free(entries);
+  return e;
+}
+
+static int index_build(const char* root, const char* out_file, const IndexFilter* filter) {
+  /* Resolve the root once, so that its own attributes and its children are read from the same file even when it is a symbolic link */
+  char* resolved = realpath(root, NULL);
+  if (resolved == NULL) return errno;
+
+  IndexBuilder builder;
+  memset(&builder, 0, sizeof(builder));
+  builder.filter = filter;
+
+  size_t root_length = strlen(resolved);
+  builder.path_capacity = root_length + 256;
+  builder.path = malloc(builder.path_capacity);
+  memcpy(builder.path, resolved, root_length + 1);
+  builder.path_length = root_length;
+  builder.relative_offset = root_length > 0 && resolved[root_length - 1] == '/' ? root_length : root_length + 1;
+  free(resolved);
+
+  int e = 0;
+  struct stat st;
+
+  if (lstat(builder.path, &st) == -1) {
+    e = errno;
+  } else {
+    e = index_builder_walk(&builder, S_ISDIR(st.st_mode));
+  }
+
+  if (e == 0) {
+    qsort(builder.records, builder.count, sizeof(IndexRecord), index_record_compare);
+    e = index_builder_write(&builder, out_file);
+  }
+
+  for (size_t i = 0; i < builder.count; i++) {
+    if (builder.records[i].owns_path) free(builder.records[i].path);
+    free(builder.records[i].name);
+    free(builder.records[i].value);
+  }
+
+  free(builder.records);
+  free(builder.path);
+  return e;
+}
+
+typedef struct {
+  char* root;
+  char* out_file;
+  IndexFilter filter;
+  napi_deferred deferred;
+  napi_async_work work;
+  int e;
+} XattrBuildIndexData;
+
+void xattr_build_index_execute(napi_env env, void* _data) {
+  XattrBuildIndexData* data = _data;
+
+  data->e = index_build(data->root, data->out_file, &data->filter);
+}
+
+void xattr_build_index_complete(napi_env env, napi_status status, void* _data) {
+  XattrBuildIndexData* data = _data;
+
+  free(data->root);
+  free(data->out_file);
+  index_filter_free(&data->filter);
+  assert(napi_delete_async_work(env, data->work) == napi_ok);
+
+  if (data->e != 0) {
+    napi_value error;
+    assert(create_xattr_error(env, data->e, &error) == napi_ok);
+    assert(napi_reject_deferred(env, data->deferred, error) == napi_ok);
+  } else {
+    napi_value undefined;
+    assert(napi_get_undefined(env, &undefined) == napi_ok);
+    assert(napi_resolve_deferred(env, data->deferred, undefined) == napi_ok);
+  }
+
+  free(_data);
+}
+
+napi_value xattr_build_index(napi_env env, napi_callback_info info) {
+  size_t argc = 4;
+  napi_value args[4];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  XattrBuildIndexData* data = malloc(sizeof(XattrBuildIndexData));
+
+  data->root = index_get_string(env, args[0], NULL);
+  data->out_file = index_get_string(env, args[1], NULL);
+  index_filter_from_args(env, args[2], args[3], &data->filter);
+
+  napi_value promise;
+  assert(napi_create_promise(env, &data->deferred, &promise) == napi_ok);
+
+  napi_value work_name;
+  assert(napi_create_string_utf8(env, "fs-xattr:buildIndex", NAPI_AUTO_LENGTH, &work_name) == napi_ok);
+
+  assert(napi_create_async_work(env, NULL, work_name, xattr_build_index_execute, xattr_build_index_complete, (void*) data, &data->work) == napi_ok);
+
+  assert(napi_queue_async_work(env, data->work) == napi_ok);
+
+  return promise;
+}
+
+napi_value xattr_build_index_sync(napi_env env, napi_callback_info info) {
+  size_t argc = 4;
+  napi_value args[4];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  char* root = index_get_string(env, args[0], NULL);
+  char* out_file = index_get_string(env, args[1], NULL);
+
+  IndexFilter filter;
+  index_filter_from_args(env, args[2], args[3], &filter);
+
+  int e = index_build(root, out_file, &filter);
+
+  free(root);
+  free(out_file);
+  index_filter_free(&filter);
+
+  if (e != 0) assert(throw_xattr_error(env, e) == napi_ok);
+
+  return NULL;
+}
+
+/* Reading */
+
+typedef struct {
+  XattrResource resource;
+  SharedMapping* mapping;
+  const char* base;
+  const IndexEntry* entries;
+  uint64_t entry_count;
+} AttributeIndex;
+
+static int index_entry_compare(const AttributeIndex* index, const IndexEntry* entry, const char* path, size_t path_length, const char* name, size_t name_length) {
+  int res = index_compare(index->base + entry->path_offset, entry->path_length, path, path_length);
+  if (res != 0) return res;
+
+  return index_compare(index->base + entry->name_offset, entry->name_length, name, name_length);
+}
+
+static uint64_t index_lower_bound(const AttributeIndex* index, const char* path, size_t path_length, const char* name, size_t name_length) {
+  uint64_t low = 0;
+  uint64_t high = index->entry_count;
+
+  while (low < high) {
+    uint64_t mid = low + (high - low) / 2;
+
+    if (index_entry_compare(index, &index->entries[mid], path, path_length, name, name_length) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+static int index_validate(const char* base, size_t size) {
+  if (size < sizeof(IndexHeader)) return 0;
+
+  const IndexHeader* header = (const IndexHeader*) base;
+  if (memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) != 0) return 0;
+  if (header->version != INDEX_VERSION) return 0;
+  if (header->entry_count > (size - sizeof(IndexHeader)) / sizeof(IndexEntry)) return 0;
+
+  const IndexEntry* entries = (const IndexEntry*) (base + sizeof(IndexHeader));
+
+  for (uint64_t i = 0; i < header->entry_count; i++) {
+    const IndexEntry* entry = &entries[i];
+
+    if (entry->path_offset > size || entry->path_length > size - entry->path_offset) return 0;
+    if (entry->name_offset > size || entry->name_length > size - entry->name_offset) return 0;
+    if (entry->value_offset > size || entry->value_length > size - entry->value_offset) return 0;
+
+    if (i > 0) {
+      const IndexEntry* previous = &entries[i - 1];
+      int res = index_compare(base + previous->path_offset, previous->path_length, base + entry->path_offset, entry->path_length);
+      if (res == 0) res = index_compare(base + previous->name_offset, previous->name_length, base + entry->name_offset, entry->name_length);
+      if (res >= 0) return 0;
+    }
+  }
+
+  return 1;
+}
+
+static void index_release(XattrResource* resource) {
+  AttributeIndex* index = (AttributeIndex*) resource;
+
+  if (index->mapping != NULL) shared_map_release(index->mapping);
+  index->mapping = NULL;
+  index->base = NULL;
+  index->entries = NULL;
+  index->entry_count = 0;
+}
+
+static void index_finalize(napi_env env, void* _data, void* hint) {
+  AttributeIndex* index = _data;
+
+  instance_untrack(&index->resource);
+  index_release(&index->resource);
+  free(index);
+}
+
+static AttributeIndex* index_from_value(napi_env env, napi_value value) {
+  AttributeIndex* index;
+  assert(napi_get_value_external(env, value, (void**) &index) == napi_ok);
+
+  if (index->base == NULL) {
+    assert(napi_throw_error(env, NULL, "The attribute index has been closed") == napi_ok);
+    return NULL;
+  }
+
+  return index;
+}
+
+static napi_value index_create_entry(napi_env env, const AttributeIndex* index, const IndexEntry* entry) {
+  napi_value result;
+  assert(napi_create_object(env, &result) == napi_ok);
+
+  napi_value path;
+  assert(napi_create_string_utf8(env, index->base + entry->path_offset, entry->path_length, &path) == napi_ok);
+  assert(napi_set_named_property(env, result, "path", path) == napi_ok);
+
+  napi_value name;
+  assert(napi_create_string_utf8(env, index->base + entry->name_offset, entry->name_length, &name) == napi_ok);
+  assert(napi_set_named_property(env, result, "name", name) == napi_ok);
+
+  napi_value value;
+  assert(napi_create_buffer_copy(env, entry->value_length, index->base + entry->value_offset, NULL, &value) == napi_ok);
+  assert(napi_set_named_property(env, result, "value", value) == napi_ok);
+
+  return result;
+}
+
+napi_value xattr_open_index(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  char* filename = index_get_string(env, args[0], NULL);
+
+  int fd = open(filename, O_RDONLY);
+  free(filename);
+
+  if (fd == -1) {
+    assert(throw_xattr_error(env, errno) == napi_ok);
+    return NULL;
+  }
+
+  /* The mapping is shared with any other environment (e.g. worker thread) that has the same file open */
+  SharedMapping* mapping;
+  int e = shared_map_acquire(fd, index_validate, &mapping);
+  close(fd);
+
+  if (e == SHARED_MAP_INVALID) {
+    assert(napi_throw_error(env, NULL, "The file is not a valid attribute index") == napi_ok);
+    return NULL;
+  }
+
+  if (e != 0) {
+    assert(throw_xattr_error(env, e) == napi_ok);
+    return NULL;
+  }
+
+  AttributeIndex* index = malloc(sizeof(AttributeIndex));
+  index->mapping = mapping;
+  index->base = shared_map_base(mapping);
+  index->entries = (const IndexEntry*) (index->base + sizeof(IndexHeader));
+  index->entry_count = ((const IndexHeader*) index->base)->entry_count;
+  instance_track(env, &index->resource, index_release);
+
+  napi_value result;
+  assert(napi_create_external(env, index, index_finalize, NULL, &result) == napi_ok);
+
+  return result;
+}
+
+napi_value xattr_index_get(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value args[3];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeIndex* index = index_from_value(env, args[0]);
+  if (index == NULL) return NULL;
+
+  size_t path_length;
+  char* path = index_get_string(env, args[1], &path_length);
+  size_t name_length;
+  char* name = index_get_string(env, args[2], &name_length);
+
+  uint64_t position = index_lower_bound(index, path, path_length, name, name_length);
+  int found = position < index->entry_count && index_entry_compare(index, &index->entries[position], path, path_length, name, name_length) == 0;
+
+  free(path);
+  free(name);
+
+  if (!found) return NULL;
+
+  const IndexEntry* entry = &index->entries[position];
+
+  napi_value buffer;
+  assert(napi_create_buffer_copy(env, entry->value_length, index->base + entry->value_offset, NULL, &buffer) == napi_ok);
+
+  return buffer;
+}
+
+napi_value xattr_index_list(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeIndex* index = index_from_value(env, args[0]);
+  if (index == NULL) return NULL;
+
+  size_t path_length;
+  char* path = index_get_string(env, args[1], &path_length);
+
+  napi_value array;
+  assert(napi_create_array(env, &array) == napi_ok);
+
+  uint32_t array_position = 0;
+
+  for (uint64_t i = index_lower_bound(index, path, path_length, "", 0); i < index->entry_count; i++) {
+    const IndexEntry* entry = &index->entries[i];
+    if (index_compare(index->base + entry->path_offset, entry->path_length, path, path_length) != 0) break;
+
+    napi_value name;
+    assert(napi_create_string_utf8(env, index->base + entry->name_offset, entry->name_length, &name) == napi_ok);
+    assert(napi_set_element(env, array, array_position++, name) == napi_ok);
+  }
+
+  free(path);
+
+  return array;
+}
+
+napi_value xattr_index_scan(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeIndex* index = index_from_value(env, args[0]);
+  if (index == NULL) return NULL;
+
+  size_t prefix_length;
+  char* prefix = index_get_string(env, args[1], &prefix_length);
+
+  napi_value array;
+  assert(napi_create_array(env, &array) == napi_ok);
+
+  uint32_t array_position = 0;
+
+  for (uint64_t i = index_lower_bound(index, prefix, prefix_length, "", 0); i < index->entry_count; i++) {
+    const IndexEntry* entry = &index->entries[i];
+    if (entry->path_length < prefix_length) break;
+    if (prefix_length > 0 && memcmp(index->base + entry->path_offset, prefix, prefix_length) != 0) break;
+
+    assert(napi_set_element(env, array, array_position++, index_create_entry(env, index, entry)) == napi_ok);
+  }
+
+  free(prefix);
+
+  return array;
+}
+
+napi_value xattr_index_close(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
+
+  AttributeIndex* index;
+  assert(napi_get_value_external(env, args[0], (void**) &index) == napi_ok);
+
+  instance_untrack(&index->resource);
+  index_release(&index->resource);
+
+  return NULL;
+}
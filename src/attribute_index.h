@@ -0,0 +1,15 @@
+#ifndef LD_ATTRIBUTE_INDEX_H
+#define LD_ATTRIBUTE_INDEX_H
+
+#define NAPI_VERSION 6
+#include <node_api.h>
+
+napi_value xattr_build_index(napi_env env, napi_callback_info info);
+napi_value xattr_build_index_sync(napi_env env, napi_callback_info info);
+napi_value xattr_open_index(napi_env env, napi_callback_info info);
+napi_value xattr_index_get(napi_env env, napi_callback_info info);
+napi_value xattr_index_list(napi_env env, napi_callback_info info);
+napi_value xattr_index_scan(napi_env env, napi_callback_info info);
+napi_value xattr_index_close(napi_env env, napi_callback_info info);
+
+#endif
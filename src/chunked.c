@@ -0,0 +1,401 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/xattr.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "chunked.h"
+
+#ifdef __APPLE__
+#define E_ENOATTR ENOATTR
+#else
+#define E_ENOATTR ENODATA
+#endif
+
+/*
+ * A chunked value is stored as a header attribute, `attr`, followed by
+ * `attr#<generation>.1` ... `attr#<generation>.n`. The header attribute holds
+ * a 32 byte header and the first part of the (optionally deflated) value, the
+ * numbered attributes hold the rest. All integers are little-endian.
+ *
+ *   0  magic "XAC1"
+ *   4  flags
+ *   8  generation, chosen anew by every write
+ *   12 number of attributes, including the header attribute
+ *   16 length of the stored value
+ *   20 length of the value after inflating (equal to the stored length when not deflated)
+ *   24 CRC-32 of the stored value
+ *   28 CRC-32 of bytes 0-27
+ *
+ * An overwrite writes the chunks of a new generation first, then replaces the
+ * header in a single call and only then removes the chunks of every other
+ * generation. If any step fails the new chunks are removed again, so the
+ * previous value stays readable. Concurrent writes to the same attribute are
+ * not serialised, the last header written wins and its chunks may have been
+ * removed by the other writer.
+ *
+ * Attributes without a valid header are returned as-is, so plain values can
+ * be read in chunked mode as well.
+ */
+
+#define CHUNK_MAGIC "XAC1"
+#define CHUNK_HEADER_LENGTH 32
+#define CHUNK_FLAG_DEFLATE 1
+#define CHUNK_READ_ATTEMPTS 8
+
+typedef struct {
+  uint32_t flags;
+  uint32_t generation;
+  uint32_t chunk_count;
+  size_t stored_length;
+  size_t raw_length;
+  uint32_t crc;
+} ChunkHeader;
+
+static void write_uint32le(unsigned char *p, uint32_t value) {
+  for (int i = 0; i < 4; i++) p[i] = (unsigned char) (value >> (i * 8));
+}
+
+static uint32_t read_uint32le(const unsigned char *p) {
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static char* chunk_name(const char *attribute, uint32_t generation, uint32_t index) {
+  size_t length = strlen(attribute) + 21;
+  char *name = malloc(length);
+  snprintf(name, length, "%s#%x.%u", attribute, generation, index);
+  return name;
+}
+
+static ssize_t chunk_get(const char *filename, const char *name, void *value, size_t size) {
+#ifdef __APPLE__
+  return getxattr(filename, name, value, size, 0, 0);
+#else
+  return getxattr(filename, name, value, size);
+#endif
+}
+
+static int chunk_set(const char *filename, const char *name, const void *value, size_t size) {
+#ifdef __APPLE__
+  return setxattr(filename, name, value, size, 0, 0);
+#else
+  return setxattr(filename, name, value, size, 0);
+#endif
+}
+
+static int chunk_remove(const char *filename, const char *name) {
+#ifdef __APPLE__
+  return removexattr(filename, name, 0);
+#else
+  return removexattr(filename, name);
+#endif
+}
+
+static ssize_t chunk_list(const char *filename, char *result, size_t size) {
+#ifdef __APPLE__
+  return listxattr(filename, result, size, 0);
+#else
+  return listxattr(filename, result, size);
+#endif
+}
+
+/* Removes `attr#<generation>.1` ... `attr#<generation>.<last>`, ignoring chunks that are already gone */
+static int remove_generation(const char *filename, const char *attribute, uint32_t generation, uint32_t last) {
+  int e = 0;
+
+  for (uint32_t i = 1; i <= last; i++) {
+    char *name = chunk_name(attribute, generation, i);
+    if (chunk_remove(filename, name) == -1 && errno != E_ENOATTR && e == 0) e = errno;
+    free(name);
+  }
+
+  return e;
+}
+
+/* Removes every `attr#<generation>.<n>` except those of generation `keep`, using a single list pass */
+static int remove_all_generations(const char *filename, const char *attribute, uint32_t keep) {
+  char *list = NULL;
+  ssize_t list_length;
+
+  for (;;) {
+    list_length = chunk_list(filename, NULL, 0);
+    if (list_length == -1) return errno;
+    if (list_length == 0) return 0;
+
+    list = malloc((size_t) list_length);
+    list_length = chunk_list(filename, list, (size_t) list_length);
+    if (list_length != -1) break;
+
+    int e = errno;
+    free(list);
+    if (e != ERANGE) return e;
+  }
+
+  size_t attribute_length = strlen(attribute);
+  size_t position = 0;
+  int e = 0;
+
+  while (e == 0 && position < (size_t) list_length) {
+    const char *name = list + position;
+    size_t name_length = strlen(name);
+    position += name_length + 1;
+
+    if (name_length <= attribute_length + 1) continue;
+    if (memcmp(name, attribute, attribute_length) != 0 || name[attribute_length] != '#') continue;
+
+    const char *generation = name + attribute_length + 1;
+    size_t generation_length = strspn(generation, "0123456789abcdef");
+    if (generation_length == 0 || generation_length > 8 || generation[generation_length] != '.') continue;
+
+    const char *index = generation + generation_length + 1;
+    if (*index == '\0' || strspn(index, "0123456789") != strlen(index)) continue;
+    if (keep != 0 && strtoul(generation, NULL, 16) == keep) continue;
+
+    if (chunk_remove(filename, name) == -1 && errno != E_ENOATTR) e = errno;
+  }
+
+  free(list);
+  return e;
+}
+
+/* Reads the whole header attribute into a newly allocated buffer */
+static int read_head(const char *filename, const char *attribute, char **result, size_t *result_length) {
+  for (;;) {
+    ssize_t length = chunk_get(filename, attribute, NULL, 0);
+    if (length == -1) return errno;
+
+    char *head = malloc((size_t) length + 1);
+    length = chunk_get(filename, attribute, head, (size_t) length);
+
+    if (length != -1) {
+      *result = head;
+      *result_length = (size_t) length;
+      return 0;
+    }
+
+    int e = errno;
+    free(head);
+    if (e != ERANGE) return e;
+  }
+}
+
+/* Returns 1 and fills `header` when `head` starts with a valid header, 0 when it is a plain value */
+static int parse_header(const char *head, size_t head_length, ChunkHeader *header) {
+  const unsigned char *p = (const unsigned char *) head;
+
+  if (head_length < CHUNK_HEADER_LENGTH || memcmp(head, CHUNK_MAGIC, 4) != 0) return 0;
+  if (read_uint32le(p + 28) != (uint32_t) crc32(0, p, 28)) return 0;
+
+  header->flags = read_uint32le(p + 4);
+  header->generation = read_uint32le(p + 8);
+  header->chunk_count = read_uint32le(p + 12);
+  header->stored_length = read_uint32le(p + 16);
+  header->raw_length = read_uint32le(p + 20);
+  header->crc = read_uint32le(p + 24);
+
+  if (header->chunk_count == 0 || header->generation == 0) return 0;
+  if (header->flags & ~(uint32_t) CHUNK_FLAG_DEFLATE) return 0;
+  if (head_length - CHUNK_HEADER_LENGTH > header->stored_length) return 0;
+  if (!(header->flags & CHUNK_FLAG_DEFLATE) && header->raw_length != header->stored_length) return 0;
+
+  return 1;
+}
+
+static uint32_t next_generation(uint32_t previous) {
+  static uint32_t counter = 0;
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  uint32_t seed[4] = { (uint32_t) now.tv_sec, (uint32_t) now.tv_nsec, (uint32_t) getpid(), __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED) };
+  uint32_t generation = (uint32_t) crc32(0, (const Bytef *) seed, sizeof(seed));
+
+  while (generation == 0 || generation == previous) generation++;
+
+  return generation;
+}
+
+/*
+ * Reads the chunks belonging to `header` into `stored`. Returns EAGAIN when a
+ * chunk is missing or the data doesn't match the checksum, which happens when
+ * a concurrent write replaced the value while it was being read.
+ */
+static int read_chunks(const char *filename, const char *attribute, const ChunkHeader *header, char *stored, size_t offset) {
+  for (uint32_t i = 1; i < header->chunk_count; i++) {
+    if (offset == header->stored_length) return EIO;
+
+    char *name = chunk_name(attribute, header->generation, i);
+    ssize_t length = chunk_get(filename, name, stored + offset, header->stored_length - offset);
+    int e = errno;
+    free(name);
+
+    if (length == -1) return e == E_ENOATTR ? EAGAIN : e == ERANGE ? EIO : e;
+
+    offset += (size_t) length;
+  }
+
+  if (offset != header->stored_length) return EIO;
+  if ((uint32_t) crc32(0, (const Bytef *) stored, (uInt) header->stored_length) != header->crc) return EAGAIN;
+
+  return 0;
+}
+
+int chunked_read(const char *filename, const char *attribute, char **result, size_t *result_length) {
+  uint32_t previous_generation = 0;
+
+  for (int attempt = 0; attempt < CHUNK_READ_ATTEMPTS; attempt++) {
+    char *head;
+    size_t head_length;
+    int e = read_head(filename, attribute, &head, &head_length);
+    if (e != 0) return e;
+
+    ChunkHeader header;
+    if (!parse_header(head, head_length, &header)) {
+      *result = head;
+      *result_length = head_length;
+      return 0;
+    }
+
+    /* The value didn't change since the last attempt, so it is actually broken */
+    if (attempt > 0 && header.generation == previous_generation) {
+      free(head);
+      return EIO;
+    }
+
+    previous_generation = header.generation;
+
+    size_t offset = head_length - CHUNK_HEADER_LENGTH;
+    char *stored = malloc(header.stored_length + 1);
+    memcpy(stored, head + CHUNK_HEADER_LENGTH, offset);
+    free(head);
+
+    e = read_chunks(filename, attribute, &header, stored, offset);
+
+    if (e == EAGAIN) {
+      free(stored);
+      continue;
+    }
+
+    if (e != 0) {
+      free(stored);
+      return e;
+    }
+
+    if (!(header.flags & CHUNK_FLAG_DEFLATE)) {
+      *result = stored;
+      *result_length = header.stored_length;
+      return 0;
+    }
+
+    char *raw = malloc(header.raw_length + 1);
+    uLongf inflated_length = (uLongf) header.raw_length;
+    int res = uncompress((Bytef *) raw, &inflated_length, (const Bytef *) stored, (uLong) header.stored_length);
+    free(stored);
+
+    if (res != Z_OK || inflated_length != header.raw_length) {
+      free(raw);
+      return EIO;
+    }
+
+    *result = raw;
+    *result_length = header.raw_length;
+    return 0;
+  }
+
+  return EIO;
+}
+
+int chunked_write(const char *filename, const char *attribute, const char *value, size_t value_length, size_t chunk_size, int compress) {
+  if (value_length > UINT32_MAX) return E2BIG;
+  if (chunk_size <= CHUNK_HEADER_LENGTH) return EINVAL;
+
+  /* Find the generation being replaced, so that the new one is guaranteed to differ from it */
+  ChunkHeader previous = { 0 };
+  char *previous_head;
+  size_t previous_head_length;
+  int e = read_head(filename, attribute, &previous_head, &previous_head_length);
+
+  if (e == 0) {
+    if (!parse_header(previous_head, previous_head_length, &previous)) previous.generation = 0;
+    free(previous_head);
+  } else if (e != E_ENOATTR) {
+    return e;
+  }
+
+  const char *stored = value;
+  size_t stored_length = value_length;
+  char *deflated = NULL;
+  uint32_t flags = 0;
+
+  if (compress && value_length > 0) {
+    uLongf deflated_length = compressBound((uLong) value_length);
+    deflated = malloc(deflated_length);
+
+    /* Only keep the deflated value when it actually saves space */
+    if (compress2((Bytef *) deflated, &deflated_length, (const Bytef *) value, (uLong) value_length, Z_DEFAULT_COMPRESSION) == Z_OK && deflated_length < value_length) {
+      stored = deflated;
+      stored_length = deflated_length;
+      flags |= CHUNK_FLAG_DEFLATE;
+    }
+  }
+
+  size_t first_length = stored_length < chunk_size - CHUNK_HEADER_LENGTH ? stored_length : chunk_size - CHUNK_HEADER_LENGTH;
+  uint32_t chunk_count = 1 + (uint32_t) ((stored_length - first_length + chunk_size - 1) / chunk_size);
+  uint32_t generation = next_generation(previous.generation);
+
+  /* Write the chunks of the new generation next to the current value, which stays readable until the header is replaced */
+  uint32_t written = 0;
+  e = 0;
+
+  for (uint32_t i = 1; e == 0 && i < chunk_count; i++) {
+    size_t offset = first_length + (i - 1) * chunk_size;
+    size_t length = stored_length - offset < chunk_size ? stored_length - offset : chunk_size;
+
+    char *name = chunk_name(attribute, generation, i);
+    if (chunk_set(filename, name, stored + offset, length) == -1) e = errno; else written = i;
+    free(name);
+  }
+
+  if (e == 0) {
+    unsigned char *head = malloc(CHUNK_HEADER_LENGTH + first_length);
+    memcpy(head, CHUNK_MAGIC, 4);
+    write_uint32le(head + 4, flags);
+    write_uint32le(head + 8, generation);
+    write_uint32le(head + 12, chunk_count);
+    write_uint32le(head + 16, (uint32_t) stored_length);
+    write_uint32le(head + 20, (uint32_t) value_length);
+    write_uint32le(head + 24, (uint32_t) crc32(0, (const Bytef *) stored, (uInt) stored_length));
+    write_uint32le(head + 28, (uint32_t) crc32(0, head, 28));
+    if (first_length > 0) memcpy(head + CHUNK_HEADER_LENGTH, stored, first_length);
+
+    if (chunk_set(filename, attribute, head, CHUNK_HEADER_LENGTH + first_length) == -1) e = errno;
+    free(head);
+  }
+
+  free(deflated);
+
+  if (e != 0) {
+    remove_generation(filename, attribute, generation, written);
+    return e;
+  }
+
+  /*
+   * The new value is in place, so remove every other generation. This also
+   * catches chunks left behind by a concurrent write that replaced the same
+   * header. Failing to remove them doesn't make the write fail.
+   */
+  remove_all_generations(filename, attribute, generation);
+
+  return 0;
+}
+
+int chunked_remove(const char *filename, const char *attribute) {
+  if (chunk_remove(filename, attribute) == -1) return errno;
+
+  return remove_all_generations(filename, attribute, 0);
+}
@@ -0,0 +1,10 @@
+#ifndef LD_CHUNKED_H
+#define LD_CHUNKED_H
+
+#include <stddef.h>
+
+int chunked_read(const char *filename, const char *attribute, char **result, size_t *result_length);
+int chunked_write(const char *filename, const char *attribute, const char *value, size_t value_length, size_t chunk_size, int compress);
+int chunked_remove(const char *filename, const char *attribute);
+
+#endif
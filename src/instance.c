@@ -0,0 +1,79 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "instance.h"
+
+static void instance_cleanup(void* arg) {
+  XattrInstance* instance = arg;
+
+  while (instance->resources.next != &instance->resources) {
+    XattrResource* resource = instance->resources.next;
+    instance_untrack(resource);
+    resource->release(resource);
+  }
+}
+
+/* Only runs when the environment is torn down, which also frees its references */
+static void instance_finalize(napi_env env, void* data, void* hint) {
+  free(data);
+}
+
+napi_status instance_init(napi_env env) {
+  napi_status status;
+
+  XattrInstance* instance = malloc(sizeof(XattrInstance));
+  instance->resources.prev = &instance->resources;
+  instance->resources.next = &instance->resources;
+
+  napi_value global;
+  status = napi_get_global(env, &global);
+  if (status != napi_ok) return status;
+
+  napi_value json;
+  status = napi_get_named_property(env, global, "JSON", &json);
+  if (status != napi_ok) return status;
+  status = napi_create_reference(env, json, 1, &instance->json);
+  if (status != napi_ok) return status;
+
+  napi_value parse;
+  status = napi_get_named_property(env, json, "parse", &parse);
+  if (status != napi_ok) return status;
+  status = napi_create_reference(env, parse, 1, &instance->json_parse);
+  if (status != napi_ok) return status;
+
+  napi_value stringify;
+  status = napi_get_named_property(env, json, "stringify", &stringify);
+  if (status != napi_ok) return status;
+  status = napi_create_reference(env, stringify, 1, &instance->json_stringify);
+  if (status != napi_ok) return status;
+
+  status = napi_set_instance_data(env, instance, instance_finalize, NULL);
+  if (status != napi_ok) return status;
+
+  return napi_add_env_cleanup_hook(env, instance_cleanup, instance);
+}
+
+XattrInstance* instance_get(napi_env env) {
+  XattrInstance* instance;
+  assert(napi_get_instance_data(env, (void**) &instance) == napi_ok);
+  return instance;
+}
+
+void instance_track(napi_env env, XattrResource* resource, void (*release)(XattrResource* resource)) {
+  XattrInstance* instance = instance_get(env);
+
+  resource->release = release;
+  resource->prev = &instance->resources;
+  resource->next = instance->resources.next;
+  instance->resources.next->prev = resource;
+  instance->resources.next = resource;
+}
+
+void instance_untrack(XattrResource* resource) {
+  if (resource->next == NULL) return;
+
+  resource->prev->next = resource->next;
+  resource->next->prev = resource->prev;
+  resource->prev = NULL;
+  resource->next = NULL;
+}
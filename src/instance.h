@@ -0,0 +1,31 @@
+#ifndef LD_INSTANCE_H
+#define LD_INSTANCE_H
+
+#define NAPI_VERSION 6
+#include <node_api.h>
+
+/*
+ * Native handles (directories, indexes) embed a resource so that the
+ * environment that created them can release them when it is torn down, e.g.
+ * when a worker thread exits, without waiting for garbage collection.
+ */
+typedef struct XattrResource {
+  struct XattrResource* prev;
+  struct XattrResource* next;
+  void (*release)(struct XattrResource* resource);
+} XattrResource;
+
+typedef struct {
+  XattrResource resources;
+  napi_ref json;
+  napi_ref json_parse;
+  napi_ref json_stringify;
+} XattrInstance;
+
+napi_status instance_init(napi_env env);
+XattrInstance* instance_get(napi_env env);
+
+void instance_track(napi_env env, XattrResource* resource, void (*release)(XattrResource* resource));
+void instance_untrack(XattrResource* resource);
+
+#endif
@@ -0,0 +1,127 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "shared.h"
+
+/*
+ * Process-wide state, shared by every environment (main thread and worker
+ * threads) that loads the addon. Read-only mappings of index files are
+ * reference counted and reused, so that any number of workers opening the
+ * same snapshot share one mapping. A file is validated before it is shared.
+ */
+
+#ifdef __APPLE__
+#define STAT_MTIME(st) ((st).st_mtimespec)
+#else
+#define STAT_MTIME(st) ((st).st_mtim)
+#endif
+
+struct SharedMapping {
+  dev_t dev;
+  ino_t ino;
+  off_t file_size;
+  struct timespec mtime;
+  const char* base;
+  size_t size;
+  uint32_t refs;
+  SharedMapping* next;
+};
+
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static SharedMapping* shared_mappings = NULL;
+
+/* Finds a mapping of the same version of the file and takes a reference on it, the caller must hold `shared_lock` */
+static SharedMapping* shared_map_find(const struct stat* st) {
+  for (SharedMapping* mapping = shared_mappings; mapping != NULL; mapping = mapping->next) {
+    if (mapping->dev != st->st_dev || mapping->ino != st->st_ino || mapping->file_size != st->st_size) continue;
+    if (mapping->mtime.tv_sec != STAT_MTIME(*st).tv_sec || mapping->mtime.tv_nsec != STAT_MTIME(*st).tv_nsec) continue;
+
+    mapping->refs += 1;
+    return mapping;
+  }
+
+  return NULL;
+}
+
+int shared_map_acquire(int fd, int (*validate)(const char* base, size_t size), SharedMapping** result) {
+  struct stat st;
+  if (fstat(fd, &st) == -1) return errno;
+
+  pthread_mutex_lock(&shared_lock);
+  SharedMapping* existing = shared_map_find(&st);
+  pthread_mutex_unlock(&shared_lock);
+
+  if (existing != NULL) {
+    *result = existing;
+    return 0;
+  }
+
+  /* Map and validate without holding the lock, since validating is a full pass over the file */
+  size_t size = (size_t) st.st_size;
+  if (size == 0) return SHARED_MAP_INVALID;
+
+  void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) return errno;
+
+  if (!validate(base, size)) {
+    munmap(base, size);
+    return SHARED_MAP_INVALID;
+  }
+
+  pthread_mutex_lock(&shared_lock);
+
+  /* Another thread may have mapped the same file in the meantime */
+  existing = shared_map_find(&st);
+
+  if (existing != NULL) {
+    pthread_mutex_unlock(&shared_lock);
+    munmap(base, size);
+    *result = existing;
+    return 0;
+  }
+
+  SharedMapping* mapping = malloc(sizeof(SharedMapping));
+  mapping->dev = st.st_dev;
+  mapping->ino = st.st_ino;
+  mapping->file_size = st.st_size;
+  mapping->mtime = STAT_MTIME(st);
+  mapping->base = base;
+  mapping->size = size;
+  mapping->refs = 1;
+  mapping->next = shared_mappings;
+  shared_mappings = mapping;
+
+  pthread_mutex_unlock(&shared_lock);
+
+  *result = mapping;
+  return 0;
+}
+
+void shared_map_release(SharedMapping* mapping) {
+  pthread_mutex_lock(&shared_lock);
+
+  mapping->refs -= 1;
+
+  if (mapping->refs == 0) {
+    for (SharedMapping** link = &shared_mappings; *link != NULL; link = &(*link)->next) {
+      if (*link == mapping) {
+        *link = mapping->next;
+        break;
+      }
+    }
+
+    munmap((void*) mapping->base, mapping->size);
+    free(mapping);
+  }
+
+  pthread_mutex_unlock(&shared_lock);
+}
+
+const char* shared_map_base(const SharedMapping* mapping) {
+  return mapping->base;
+}
@@ -0,0 +1,14 @@
+#ifndef LD_SHARED_H
+#define LD_SHARED_H
+
+#include <stddef.h>
+
+#define SHARED_MAP_INVALID -1
+
+typedef struct SharedMapping SharedMapping;
+
+int shared_map_acquire(int fd, int (*validate)(const char* base, size_t size), SharedMapping** result);
+void shared_map_release(SharedMapping* mapping);
+const char* shared_map_base(const SharedMapping* mapping);
+
+#endif
@@ -3,14 +3,15 @@
 #include <stdlib.h>
 #include <sys/xattr.h>
 
+#include "chunked.h"
 #include "error.h"
 #include "util.h"
 
 #include "sync.h"
 
 napi_value xattr_get_sync(napi_env env, napi_callback_info info) {
-  size_t argc = 2;
-  napi_value args[2];
+  size_t argc = 4;
+  napi_value args[4];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   size_t filename_length;
@@ -23,6 +24,35 @@ napi_value xattr_get_sync(napi_env env, napi_callback_info info) {
   char *attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], attribute, attribute_length + 1, NULL) == napi_ok);
 
+  xattr_encoding encoding;
+  assert(get_encoding(env, args[2], &encoding) == napi_ok);
+
+  bool chunked;
+  assert(napi_get_value_bool(env, args[3], &chunked) == napi_ok);
+
+  if (chunked) {
+    char *value;
+    size_t value_length;
+    int e = chunked_read(filename, attribute, &value, &value_length);
+
+    free(filename);
+    free(attribute);
+
+    if (e != 0) {
+      assert(throw_xattr_error(env, e) == napi_ok);
+      return NULL;
+    }
+
+    napi_value result;
+    napi_status status = decode_value(env, encoding, value, value_length, &result);
+    free(value);
+
+    if (status == napi_pending_exception) return NULL;
+    assert(status == napi_ok);
+
+    return result;
+  }
+
   ssize_t value_length;
 
 #ifdef __APPLE__
@@ -40,7 +70,13 @@ napi_value xattr_get_sync(napi_env env, napi_callback_info info) {
 
   napi_value buffer;
   void* buffer_data;
-  assert(napi_create_buffer(env, (size_t) value_length, &buffer_data, &buffer) == napi_ok);
+
+  /* Buffers are read straight into their backing store, other encodings are decoded from a scratch copy */
+  if (encoding == XATTR_ENCODING_BUFFER) {
+    assert(napi_create_buffer(env, (size_t) value_length, &buffer_data, &buffer) == napi_ok);
+  } else {
+    buffer_data = malloc((size_t) value_length + 1);
+  }
 
 #ifdef __APPLE__
   value_length = getxattr(filename, attribute, buffer_data, (size_t) value_length, 0, 0);
@@ -48,20 +84,32 @@ napi_value xattr_get_sync(napi_env env, napi_callback_info info) {
   value_length = getxattr(filename, attribute, buffer_data, (size_t) value_length);
 #endif
 
+  int e = errno;
+
   free(filename);
   free(attribute);
 
   if (value_length == -1) {
-    assert(throw_xattr_error(env, errno) == napi_ok);
+    if (encoding != XATTR_ENCODING_BUFFER) free(buffer_data);
+    assert(throw_xattr_error(env, e) == napi_ok);
     return NULL;
   }
 
-  return buffer;
+  if (encoding == XATTR_ENCODING_BUFFER) return buffer;
+
+  napi_value result;
+  napi_status status = decode_value(env, encoding, buffer_data, (size_t) value_length, &result);
+  free(buffer_data);
+
+  if (status == napi_pending_exception) return NULL;
+  assert(status == napi_ok);
+
+  return result;
 }
 
 napi_value xattr_set_sync(napi_env env, napi_callback_info info) {
-  size_t argc = 3;
-  napi_value args[3];
+  size_t argc = 6;
+  napi_value args[6];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   size_t filename_length;
@@ -74,21 +122,46 @@ napi_value xattr_set_sync(napi_env env, napi_callback_info info) {
   char *attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], attribute, attribute_length + 1, NULL) == napi_ok);
 
-  void *value;
+  xattr_encoding encoding;
+  assert(get_encoding(env, args[3], &encoding) == napi_ok);
+
+  char *value;
   size_t value_length;
-  assert(napi_get_buffer_info(env, args[2], &value, &value_length) == napi_ok);
+  int owns_value;
+  napi_status status = encode_value(env, encoding, args[2], &value, &value_length, &owns_value);
+  if (status == napi_pending_exception) {
+    free(filename);
+    free(attribute);
+    return NULL;
+  }
+  assert(status == napi_ok);
+
+  uint32_t chunk_size;
+  assert(napi_get_value_uint32(env, args[4], &chunk_size) == napi_ok);
+  bool compress;
+  assert(napi_get_value_bool(env, args[5], &compress) == napi_ok);
+
+  int res;
+  int e;
 
+  if (chunk_size != 0) {
+    e = chunked_write(filename, attribute, value, value_length, chunk_size, compress);
+    res = e == 0 ? 0 : -1;
+  } else {
 #ifdef __APPLE__
-  int res = setxattr(filename, attribute, value, value_length, 0, 0);
+    res = setxattr(filename, attribute, value, value_length, 0, 0);
 #else
-  int res = setxattr(filename, attribute, value, value_length, 0);
+    res = setxattr(filename, attribute, value, value_length, 0);
 #endif
+    e = errno;
+  }
 
   free(filename);
   free(attribute);
+  if (owns_value) free(value);
 
   if (res == -1) {
-    assert(throw_xattr_error(env, errno) == napi_ok);
+    assert(throw_xattr_error(env, e) == napi_ok);
     return NULL;
   }
 
@@ -144,8 +217,8 @@ napi_value xattr_list_sync(napi_env env, napi_callback_info info) {
 }
 
 napi_value xattr_remove_sync(napi_env env, napi_callback_info info) {
-  size_t argc = 2;
-  napi_value args[2];
+  size_t argc = 3;
+  napi_value args[3];
   assert(napi_get_cb_info(env, info, &argc, args, NULL, NULL) == napi_ok);
 
   size_t filename_length;
@@ -158,17 +231,29 @@ napi_value xattr_remove_sync(napi_env env, napi_callback_info info) {
   char *attribute = malloc(attribute_length + 1);
   assert(napi_get_value_string_utf8(env, args[1], attribute, attribute_length + 1, NULL) == napi_ok);
 
+  bool chunked;
+  assert(napi_get_value_bool(env, args[2], &chunked) == napi_ok);
+
+  int res;
+  int e;
+
+  if (chunked) {
+    e = chunked_remove(filename, attribute);
+    res = e == 0 ? 0 : -1;
+  } else {
 #ifdef __APPLE__
-  int res = removexattr(filename, attribute, 0);
+    res = removexattr(filename, attribute, 0);
 #else
-  int res = removexattr(filename, attribute);
+    res = removexattr(filename, attribute);
 #endif
+    e = errno;
+  }
 
   free(filename);
   free(attribute);
 
   if (res == -1) {
-    assert(throw_xattr_error(env, errno) == napi_ok);
+    assert(throw_xattr_error(env, e) == napi_ok);
     return NULL;
   }
 
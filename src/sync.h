@@ -1,7 +1,7 @@
 #ifndef LD_SYNC_H
 #define LD_SYNC_H
 
-#define NAPI_VERSION 1
+#define NAPI_VERSION 6
 #include <node_api.h>
 
 napi_value xattr_get_sync(napi_env env, napi_callback_info info);
@@ -1,5 +1,8 @@
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "instance.h"
 #include "util.h"
 
 napi_status split_string_array(napi_env env, const char *data, size_t length, napi_value* result) {
@@ -36,3 +39,156 @@ napi_status split_string_array(napi_env env, const char *data, size_t length, na
   *result = array;
   return napi_ok;
 }
+
+napi_status get_encoding(napi_env env, napi_value value, xattr_encoding* result) {
+  napi_status status;
+
+  uint32_t encoding;
+  status = napi_get_value_uint32(env, value, &encoding);
+  if (status != napi_ok) return status;
+
+  *result = (xattr_encoding) encoding;
+  return napi_ok;
+}
+
+static napi_status call_json(napi_env env, napi_ref method, napi_value arg, napi_value* result) {
+  napi_status status;
+
+  napi_value json;
+  status = napi_get_reference_value(env, instance_get(env)->json, &json);
+  if (status != napi_ok) return status;
+
+  napi_value fn;
+  status = napi_get_reference_value(env, method, &fn);
+  if (status != napi_ok) return status;
+
+  return napi_call_function(env, json, fn, 1, &arg, result);
+}
+
+napi_status decode_value(napi_env env, xattr_encoding encoding, const char *data, size_t length, napi_value* result) {
+  napi_status status;
+
+  switch (encoding) {
+    case XATTR_ENCODING_UTF8:
+      return napi_create_string_utf8(env, data, length, result);
+    case XATTR_ENCODING_LATIN1:
+      return napi_create_string_latin1(env, data, length, result);
+    case XATTR_ENCODING_UINT64LE: {
+      if (length != 8) {
+        status = napi_throw_range_error(env, "ERR_OUT_OF_RANGE", "The attribute value is not 8 bytes long and can't be decoded as uint64le.");
+        if (status != napi_ok) return status;
+        return napi_pending_exception;
+      }
+
+      const unsigned char *bytes = (const unsigned char *) data;
+      uint64_t number = 0;
+      for (int i = 7; i >= 0; i--) number = (number << 8) | bytes[i];
+
+      return napi_create_bigint_uint64(env, number, result);
+    }
+    case XATTR_ENCODING_JSON: {
+      napi_value string;
+      status = napi_create_string_utf8(env, data, length, &string);
+      if (status != napi_ok) return status;
+
+      return call_json(env, instance_get(env)->json_parse, string, result);
+    }
+    default:
+      return napi_create_buffer_copy(env, length, data, NULL, result);
+  }
+}
+
+static napi_status encode_string(napi_env env, xattr_encoding encoding, napi_value value, char **data, size_t *length) {
+  napi_status status;
+
+  size_t string_length;
+  if (encoding == XATTR_ENCODING_LATIN1) {
+    status = napi_get_value_string_latin1(env, value, NULL, 0, &string_length);
+  } else {
+    status = napi_get_value_string_utf8(env, value, NULL, 0, &string_length);
+  }
+  if (status != napi_ok) return status;
+
+  char *string = malloc(string_length + 1);
+
+  if (encoding == XATTR_ENCODING_LATIN1) {
+    status = napi_get_value_string_latin1(env, value, string, string_length + 1, NULL);
+  } else {
+    status = napi_get_value_string_utf8(env, value, string, string_length + 1, NULL);
+  }
+
+  if (status != napi_ok) {
+    free(string);
+    return status;
+  }
+
+  *data = string;
+  *length = string_length;
+  return napi_ok;
+}
+
+napi_status encode_value(napi_env env, xattr_encoding encoding, napi_value value, char **data, size_t *length, int *owned) {
+  napi_status status;
+
+  /* Buffers are always stored as-is, whatever the encoding */
+  bool is_buffer;
+  status = napi_is_buffer(env, value, &is_buffer);
+  if (status != napi_ok) return status;
+
+  if (is_buffer) {
+    *owned = 0;
+    return napi_get_buffer_info(env, value, (void **) data, length);
+  }
+
+  if (encoding == XATTR_ENCODING_JSON) {
+    napi_value string;
+    status = call_json(env, instance_get(env)->json_stringify, value, &string);
+    if (status != napi_ok) return status;
+
+    napi_valuetype string_type;
+    status = napi_typeof(env, string, &string_type);
+    if (status != napi_ok) return status;
+
+    if (string_type != napi_string) {
+      status = napi_throw_type_error(env, NULL, "`value` can't be encoded as JSON");
+      if (status != napi_ok) return status;
+      return napi_pending_exception;
+    }
+
+    *owned = 1;
+    return encode_string(env, XATTR_ENCODING_UTF8, string, data, length);
+  }
+
+  napi_valuetype type;
+  status = napi_typeof(env, value, &type);
+  if (status != napi_ok) return status;
+
+  if (type == napi_string) {
+    *owned = 1;
+    return encode_string(env, encoding, value, data, length);
+  }
+
+  if (type == napi_number || type == napi_bigint) {
+    uint64_t number;
+
+    if (type == napi_number) {
+      int64_t signed_number;
+      status = napi_get_value_int64(env, value, &signed_number);
+      number = (uint64_t) signed_number;
+    } else {
+      bool lossless;
+      status = napi_get_value_bigint_uint64(env, value, &number, &lossless);
+    }
+    if (status != napi_ok) return status;
+
+    unsigned char *bytes = malloc(8);
+    for (int i = 0; i < 8; i++) bytes[i] = (unsigned char) (number >> (i * 8));
+
+    *owned = 1;
+    *data = (char *) bytes;
+    *length = 8;
+    return napi_ok;
+  }
+
+  return napi_invalid_arg;
+}
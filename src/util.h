@@ -3,9 +3,21 @@
 
 #include <stddef.h>
 
-#define NAPI_VERSION 1
+#define NAPI_VERSION 6
 #include <node_api.h>
 
+/* Must match the order of `encodings` in index.js */
+typedef enum {
+  XATTR_ENCODING_BUFFER = 0,
+  XATTR_ENCODING_UTF8 = 1,
+  XATTR_ENCODING_LATIN1 = 2,
+  XATTR_ENCODING_UINT64LE = 3,
+  XATTR_ENCODING_JSON = 4
+} xattr_encoding;
+
 napi_status split_string_array(napi_env env, const char *data, size_t length, napi_value* result);
+napi_status get_encoding(napi_env env, napi_value value, xattr_encoding* result);
+napi_status decode_value(napi_env env, xattr_encoding encoding, const char *data, size_t length, napi_value* result);
+napi_status encode_value(napi_env env, xattr_encoding encoding, napi_value value, char **data, size_t *length, int *owned);
 
 #endif
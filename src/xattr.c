@@ -1,12 +1,17 @@
 #include <assert.h>
 
-#define NAPI_VERSION 1
+#define NAPI_VERSION 6
 #include <node_api.h>
 
 #include "async.h"
+#include "attribute_dir.h"
+#include "attribute_index.h"
+#include "instance.h"
 #include "sync.h"
 
 static napi_value Init(napi_env env, napi_value exports) {
+  assert(instance_init(env) == napi_ok);
+
   napi_value result;
   assert(napi_create_object(env, &result) == napi_ok);
 
@@ -36,6 +41,59 @@ static napi_value Init(napi_env env, napi_value exports) {
   assert(napi_create_function(env, "removeSync", NAPI_AUTO_LENGTH, xattr_remove_sync, NULL, &remove_sync_fn) == napi_ok);
   assert(napi_set_named_property(env, result, "removeSync", remove_sync_fn) == napi_ok);
 
+  napi_value build_index_fn;
+  assert(napi_create_function(env, "buildIndex", NAPI_AUTO_LENGTH, xattr_build_index, NULL, &build_index_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "buildIndex", build_index_fn) == napi_ok);
+  napi_value build_index_sync_fn;
+  assert(napi_create_function(env, "buildIndexSync", NAPI_AUTO_LENGTH, xattr_build_index_sync, NULL, &build_index_sync_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "buildIndexSync", build_index_sync_fn) == napi_ok);
+  napi_value open_index_fn;
+  assert(napi_create_function(env, "openIndex", NAPI_AUTO_LENGTH, xattr_open_index, NULL, &open_index_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "openIndex", open_index_fn) == napi_ok);
+  napi_value index_get_fn;
+  assert(napi_create_function(env, "indexGet", NAPI_AUTO_LENGTH, xattr_index_get, NULL, &index_get_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "indexGet", index_get_fn) == napi_ok);
+  napi_value index_list_fn;
+  assert(napi_create_function(env, "indexList", NAPI_AUTO_LENGTH, xattr_index_list, NULL, &index_list_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "indexList", index_list_fn) == napi_ok);
+  napi_value index_scan_fn;
+  assert(napi_create_function(env, "indexScan", NAPI_AUTO_LENGTH, xattr_index_scan, NULL, &index_scan_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "indexScan", index_scan_fn) == napi_ok);
+  napi_value index_close_fn;
+  assert(napi_create_function(env, "indexClose", NAPI_AUTO_LENGTH, xattr_index_close, NULL, &index_close_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "indexClose", index_close_fn) == napi_ok);
+
+  napi_value open_dir_fn;
+  assert(napi_create_function(env, "openDir", NAPI_AUTO_LENGTH, xattr_open_dir, NULL, &open_dir_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "openDir", open_dir_fn) == napi_ok);
+  napi_value dir_get_fn;
+  assert(napi_create_function(env, "dirGet", NAPI_AUTO_LENGTH, xattr_dir_get, NULL, &dir_get_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirGet", dir_get_fn) == napi_ok);
+  napi_value dir_get_sync_fn;
+  assert(napi_create_function(env, "dirGetSync", NAPI_AUTO_LENGTH, xattr_dir_get_sync, NULL, &dir_get_sync_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirGetSync", dir_get_sync_fn) == napi_ok);
+  napi_value dir_set_fn;
+  assert(napi_create_function(env, "dirSet", NAPI_AUTO_LENGTH, xattr_dir_set, NULL, &dir_set_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirSet", dir_set_fn) == napi_ok);
+  napi_value dir_set_sync_fn;
+  assert(napi_create_function(env, "dirSetSync", NAPI_AUTO_LENGTH, xattr_dir_set_sync, NULL, &dir_set_sync_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirSetSync", dir_set_sync_fn) == napi_ok);
+  napi_value dir_list_fn;
+  assert(napi_create_function(env, "dirList", NAPI_AUTO_LENGTH, xattr_dir_list, NULL, &dir_list_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirList", dir_list_fn) == napi_ok);
+  napi_value dir_list_sync_fn;
+  assert(napi_create_function(env, "dirListSync", NAPI_AUTO_LENGTH, xattr_dir_list_sync, NULL, &dir_list_sync_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirListSync", dir_list_sync_fn) == napi_ok);
+  napi_value dir_remove_fn;
+  assert(napi_create_function(env, "dirRemove", NAPI_AUTO_LENGTH, xattr_dir_remove, NULL, &dir_remove_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirRemove", dir_remove_fn) == napi_ok);
+  napi_value dir_remove_sync_fn;
+  assert(napi_create_function(env, "dirRemoveSync", NAPI_AUTO_LENGTH, xattr_dir_remove_sync, NULL, &dir_remove_sync_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirRemoveSync", dir_remove_sync_fn) == napi_ok);
+  napi_value dir_close_fn;
+  assert(napi_create_function(env, "dirClose", NAPI_AUTO_LENGTH, xattr_dir_close, NULL, &dir_close_fn) == napi_ok);
+  assert(napi_set_named_property(env, result, "dirClose", dir_close_fn) == napi_ok);
+
   return result;
 }
 
@@ -6,6 +6,10 @@ import assert from 'node:assert'
 import crypto from 'node:crypto'
 import fs from 'node:fs'
 import os from 'node:os'
+import util from 'node:util'
+import v8 from 'node:v8'
+import vm from 'node:vm'
+import { Worker } from 'node:worker_threads'
 
 import temp from 'fs-temp'
 
@@ -14,6 +18,24 @@ const attribute1 = 'user.linusu.secondary'
 const payload0 = crypto.randomBytes(24).toString('hex')
 const payload1 = crypto.randomBytes(24).toString('hex')
 
+const workerSource = `
+const { parentPort, workerData } = require('worker_threads')
+
+import(workerData.module).then(async (xattr) => {
+  await xattr.setAttribute(workerData.path, workerData.attr, { id: workerData.id }, { encoding: 'json' })
+  const value = xattr.getAttributeSync(workerData.path, workerData.attr, { encoding: 'json' })
+
+  const dir = xattr.openAttributeDir(workerData.root)
+  await dir.set(workerData.name, workerData.attr, String(workerData.id))
+
+  const index = xattr.openAttributeIndex(workerData.index)
+  const indexed = index.get('', workerData.indexAttr).toString()
+
+  // Leave the directory and the index open, they are released when the worker exits
+  parentPort.postMessage({ id: value.id, indexed })
+})
+`
+
 describe('xattr#sync', function () {
   let path
 
@@ -152,3 +174,413 @@ describe('xattr#utf8', function () {
     fs.unlink(path, done)
   })
 })
+
+describe('xattr#encoding', function () {
+  let path
+
+  before(function () {
+    path = temp.writeFileSync('')
+  })
+
+  it('should decode strings', async function () {
+    xattr.setAttributeSync(path, attribute0, '∞ ' + payload0)
+    assert.strictEqual(xattr.getAttributeSync(path, attribute0, { encoding: 'utf8' }), '∞ ' + payload0)
+    assert.strictEqual(await xattr.getAttribute(path, attribute0, { encoding: 'utf8' }), '∞ ' + payload0)
+
+    await xattr.setAttribute(path, attribute0, 'æøå', { encoding: 'latin1' })
+    assert.deepStrictEqual(xattr.getAttributeSync(path, attribute0), Buffer.from('æøå', 'latin1'))
+    assert.strictEqual(await xattr.getAttribute(path, attribute0, { encoding: 'latin1' }), 'æøå')
+  })
+
+  it('should encode and decode integers', async function () {
+    xattr.setAttributeSync(path, attribute0, 42)
+    assert.strictEqual(xattr.getAttributeSync(path, attribute0).readBigUInt64LE(), 42n)
+
+    await xattr.setAttribute(path, attribute0, 0xfedcba9876543210n)
+    assert.strictEqual(await xattr.getAttribute(path, attribute0, { encoding: 'uint64le' }), 0xfedcba9876543210n)
+    assert.strictEqual(xattr.getAttributeSync(path, attribute0, { encoding: 'uint64le' }), 0xfedcba9876543210n)
+
+    xattr.setAttributeSync(path, attribute0, 'short')
+    assert.throws(() => xattr.getAttributeSync(path, attribute0, { encoding: 'uint64le' }), RangeError)
+    await assert.rejects(xattr.getAttribute(path, attribute0, { encoding: 'uint64le' }), RangeError)
+  })
+
+  it('should encode and decode json', async function () {
+    const value = { payload: payload0, list: [1, 2, 3] }
+
+    await xattr.setAttribute(path, attribute0, value, { encoding: 'json' })
+    assert.deepStrictEqual(await xattr.getAttribute(path, attribute0, { encoding: 'json' }), value)
+    assert.deepStrictEqual(xattr.getAttributeSync(path, attribute0, { encoding: 'json' }), value)
+
+    xattr.setAttributeSync(path, attribute0, Buffer.from('{"a":1}'), { encoding: 'json' })
+    assert.deepStrictEqual(xattr.getAttributeSync(path, attribute0, { encoding: 'json' }), { a: 1 })
+
+    xattr.setAttributeSync(path, attribute0, '{')
+    assert.throws(() => xattr.getAttributeSync(path, attribute0, { encoding: 'json' }), SyntaxError)
+    await assert.rejects(xattr.getAttribute(path, attribute0, { encoding: 'json' }), SyntaxError)
+  })
+
+  it('should validate the encoding', function () {
+    assert.throws(() => xattr.getAttributeSync(path, attribute0, { encoding: 'hex' }), TypeError)
+    assert.throws(() => xattr.setAttributeSync(path, attribute0, -1), TypeError)
+    assert.throws(() => xattr.setAttributeSync(path, attribute0, 42, { encoding: 'utf8' }), TypeError)
+    assert.throws(() => xattr.setAttributeSync(path, attribute0, 'abc', { encoding: 'uint64le' }), TypeError)
+  })
+
+  after(function (done) {
+    fs.unlink(path, done)
+  })
+})
+
+describe('xattr#chunked', function () {
+  let path
+
+  function chunks (attr) {
+    return xattr.listAttributesSync(path).filter((name) => name.startsWith(`${attr}#`))
+  }
+
+  before(function () {
+    path = temp.writeFileSync('')
+  })
+
+  it('should split large values over several attributes', async function () {
+    const value = crypto.randomBytes(2000)
+
+    await xattr.setAttribute(path, attribute0, value, { chunked: true, chunkSize: 512 })
+    assert.strictEqual(chunks(attribute0).length, 3)
+    assert.deepStrictEqual(await xattr.getAttribute(path, attribute0, { chunked: true }), value)
+
+    xattr.setAttributeSync(path, attribute0, value.slice(0, 100), { chunked: true, chunkSize: 512 })
+    assert.deepStrictEqual(chunks(attribute0), [])
+    assert.deepStrictEqual(xattr.getAttributeSync(path, attribute0, { chunked: true }), value.slice(0, 100))
+  })
+
+  it('should compress values', async function () {
+    const value = payload0.repeat(100)
+
+    xattr.setAttributeSync(path, attribute0, value, { compress: true })
+    assert.ok(xattr.getAttributeSync(path, attribute0).length < value.length)
+    assert.strictEqual(await xattr.getAttribute(path, attribute0, { chunked: true, encoding: 'utf8' }), value)
+  })
+
+  it('should read plain values', function () {
+    xattr.setAttributeSync(path, attribute1, payload1)
+    assert.strictEqual(xattr.getAttributeSync(path, attribute1, { chunked: true, encoding: 'utf8' }), payload1)
+  })
+
+  it('should remove chunks left behind by other writes', function () {
+    xattr.setAttributeSync(path, `${attribute0}#deadbeef.1`, 'orphan')
+    xattr.setAttributeSync(path, attribute0, crypto.randomBytes(1500), { chunked: true, chunkSize: 512 })
+
+    assert.strictEqual(chunks(attribute0).length, 2)
+    assert.ok(!chunks(attribute0).includes(`${attribute0}#deadbeef.1`))
+  })
+
+  it('should keep the old value when an overwrite fails', async function () {
+    const value = crypto.randomBytes(1500)
+    xattr.setAttributeSync(path, attribute0, value, { chunked: true, chunkSize: 512 })
+    const before = chunks(attribute0)
+
+    // Fails part way through on filesystems that limit the total size of attributes per file, e.g. ext4
+    const large = crypto.randomBytes(65536)
+    try {
+      await xattr.setAttribute(path, attribute0, large, { chunked: true, chunkSize: 512 })
+    } catch (err) {
+      assert.throws(() => xattr.setAttributeSync(path, attribute0, large, { chunked: true, chunkSize: 512 }))
+      assert.deepStrictEqual(xattr.getAttributeSync(path, attribute0, { chunked: true }), value)
+      assert.deepStrictEqual(chunks(attribute0), before)
+      return
+    }
+
+    this.skip()
+  })
+
+  it('should read plain values that look like a header', function () {
+    const value = Buffer.alloc(64, 0xff)
+    value.write('XAC1')
+
+    xattr.setAttributeSync(path, attribute1, value)
+    assert.deepStrictEqual(xattr.getAttributeSync(path, attribute1, { chunked: true }), value)
+  })
+
+  it('should remove all chunks', async function () {
+    await xattr.setAttribute(path, attribute0, crypto.randomBytes(2000), { chunked: true, chunkSize: 512 })
+    await xattr.removeAttribute(path, attribute0, { chunked: true })
+    xattr.removeAttributeSync(path, attribute1, { chunked: true })
+
+    assert.deepStrictEqual(xattr.listAttributesSync(path), [])
+  })
+
+  after(function (done) {
+    fs.unlink(path, done)
+  })
+})
+
+describe('xattr#dir', function () {
+  let root
+
+  before(function () {
+    root = temp.mkdirSync()
+    fs.writeFileSync(`${root}/a`, '')
+    fs.symlinkSync('a', `${root}/link`)
+  })
+
+  it('should set and get attributes relative to the directory', async function () {
+    const dir = xattr.openAttributeDir(root)
+
+    await dir.set('a', attribute0, payload0)
+    dir.setSync('a', attribute1, payload1)
+
+    assert.strictEqual((await dir.get('a', attribute0)).toString(), payload0)
+    assert.strictEqual(dir.getSync('a', attribute1, { encoding: 'utf8' }), payload1)
+    assert.strictEqual(xattr.getAttributeSync(`${root}/a`, attribute0).toString(), payload0)
+
+    dir.close()
+  })
+
+  it('should keep buffer values alive until they have been set', async function () {
+    v8.setFlagsFromString('--expose-gc')
+    const gc = vm.runInNewContext('gc')
+    const dir = xattr.openAttributeDir(root)
+
+    // Occupy the thread pool, so that the value is collected while the call is still queued
+    const busy = Array.from({ length: 4 }, () => util.promisify(crypto.pbkdf2)('', '', 200000, 32, 'sha512'))
+    const pending = dir.set('a', attribute1, Buffer.alloc(192, payload0))
+    await new Promise((resolve) => setTimeout(resolve, 10))
+    gc()
+    await Promise.all([pending, ...busy])
+
+    assert.strictEqual(dir.getSync('a', attribute1, { encoding: 'latin1' }), Buffer.alloc(192, payload0).toString('latin1'))
+
+    dir.close()
+  })
+
+  it('should follow symbolic links unless asked not to', async function () {
+    const dir = xattr.openAttributeDir(root)
+
+    assert.ok((await dir.list('link')).includes(attribute0))
+    assert.ok(!dir.listSync('link', { noFollow: true }).includes(attribute0))
+
+    dir.close()
+  })
+
+  it('should remove attributes', async function () {
+    const dir = xattr.openAttributeDir(root)
+
+    await dir.remove('a', attribute0)
+    dir.removeSync('a', attribute1)
+    assert.deepStrictEqual(dir.listSync('a'), [])
+
+    dir.close()
+    assert.throws(() => dir.listSync('a'))
+  })
+
+  it('should give useful errors', async function () {
+    const dir = xattr.openAttributeDir(root)
+
+    await assert.rejects(dir.get('a', attribute0), { code: os.platform() === 'darwin' ? 'ENOATTR' : 'ENODATA' })
+    assert.throws(() => dir.getSync('missing', attribute0), { code: 'ENOENT' })
+
+    dir.close()
+  })
+
+  after(function () {
+    fs.unlinkSync(`${root}/link`)
+    fs.unlinkSync(`${root}/a`)
+    fs.rmdirSync(root)
+  })
+})
+
+describe('xattr#index', function () {
+  let root
+  let indexFile
+
+  before(function () {
+    root = temp.mkdirSync()
+    indexFile = temp.writeFileSync('')
+
+    fs.mkdirSync(`${root}/sub`)
+    fs.writeFileSync(`${root}/a`, '')
+    fs.writeFileSync(`${root}/sub/b`, '')
+
+    xattr.setAttributeSync(root, attribute0, 'root')
+    xattr.setAttributeSync(`${root}/a`, attribute0, payload0)
+    xattr.setAttributeSync(`${root}/a`, attribute1, payload1)
+    xattr.setAttributeSync(`${root}/sub/b`, attribute1, payload1)
+  })
+
+  it('should build an index', async function () {
+    await xattr.buildAttributeIndex(root, indexFile)
+  })
+
+  it('should get attributes from the index', function () {
+    const index = xattr.openAttributeIndex(indexFile)
+
+    assert.strictEqual(index.get('', attribute0).toString(), 'root')
+    assert.strictEqual(index.get('a', attribute0).toString(), payload0)
+    assert.strictEqual(index.get('sub/b', attribute1).toString(), payload1)
+    assert.strictEqual(index.get('sub/b', attribute0), undefined)
+    assert.strictEqual(index.get('missing', attribute0), undefined)
+
+    index.close()
+  })
+
+  it('should list and scan the index', function () {
+    const index = xattr.openAttributeIndex(indexFile)
+
+    assert.deepStrictEqual(index.list('a'), [attribute1, attribute0])
+    assert.deepStrictEqual(index.scan('sub/').map(entry => [entry.path, entry.name]), [['sub/b', attribute1]])
+    assert.strictEqual(index.scan('').length, 4)
+
+    index.close()
+    assert.throws(() => index.get('a', attribute0))
+  })
+
+  it('should build the same index concurrently', async function () {
+    await Promise.all([
+      xattr.buildAttributeIndex(root, indexFile),
+      xattr.buildAttributeIndex(root, indexFile),
+      xattr.buildAttributeIndex(root, indexFile)
+    ])
+
+    const index = xattr.openAttributeIndex(indexFile)
+    assert.strictEqual(index.scan('').length, 4)
+    index.close()
+  })
+
+  it('should skip entries that can\'t be read', async function () {
+    if (process.getuid() === 0) return this.skip()
+
+    fs.mkdirSync(`${root}/locked`, 0)
+
+    try {
+      await xattr.buildAttributeIndex(root, indexFile)
+    } finally {
+      fs.rmdirSync(`${root}/locked`)
+    }
+
+    const index = xattr.openAttributeIndex(indexFile)
+    assert.strictEqual(index.scan('').length, 4)
+    index.close()
+  })
+
+  it('should not reuse a mapping after the file was rewritten in place', async function () {
+    xattr.buildAttributeIndexSync(root, indexFile)
+    const index = xattr.openAttributeIndex(indexFile)
+    const size = fs.statSync(indexFile).size
+
+    await new Promise((resolve) => setTimeout(resolve, 20))
+    fs.writeFileSync(indexFile, Buffer.alloc(size, 0xff))
+
+    try {
+      assert.throws(() => xattr.openAttributeIndex(indexFile))
+    } finally {
+      index.close()
+    }
+  })
+
+  it('should respect the umask when writing the index', function () {
+    const mask = process.umask(0o077)
+
+    try {
+      xattr.buildAttributeIndexSync(root, indexFile)
+    } finally {
+      process.umask(mask)
+    }
+
+    assert.strictEqual(fs.statSync(indexFile).mode & 0o777, 0o600)
+  })
+
+  it('should follow a symbolic link as root', async function () {
+    const link = `${root}.link`
+    fs.symlinkSync(root, link)
+
+    try {
+      await xattr.buildAttributeIndex(link, indexFile)
+    } finally {
+      fs.unlinkSync(link)
+    }
+
+    const index = xattr.openAttributeIndex(indexFile)
+    assert.deepStrictEqual(index.scan('').map(entry => entry.path), ['', 'a', 'a', 'sub/b'])
+    index.close()
+  })
+
+  it('should filter attributes when building', function () {
+    xattr.buildAttributeIndexSync(root, indexFile, { names: [attribute0] })
+
+    const index = xattr.openAttributeIndex(indexFile)
+    assert.deepStrictEqual(index.scan('').map(entry => entry.path), ['', 'a'])
+    index.close()
+  })
+
+  after(function () {
+    fs.unlinkSync(`${root}/sub/b`)
+    fs.unlinkSync(`${root}/a`)
+    fs.rmdirSync(`${root}/sub`)
+    fs.rmdirSync(root)
+    fs.unlinkSync(indexFile)
+  })
+})
+
+describe('xattr#workers', function () {
+  let root
+  let indexFile
+
+  before(function () {
+    root = temp.mkdirSync()
+    indexFile = temp.writeFileSync('')
+
+    xattr.setAttributeSync(root, attribute0, payload0)
+    xattr.buildAttributeIndexSync(root, indexFile)
+  })
+
+  function spawn (id) {
+    const name = `file-${id}`
+    fs.writeFileSync(`${root}/${name}`, '')
+
+    return new Worker(workerSource, {
+      eval: true,
+      workerData: { module: new URL('../index.js', import.meta.url).href, id, root, name, path: `${root}/${name}`, attr: attribute1, indexAttr: attribute0, index: indexFile }
+    })
+  }
+
+  function run (worker) {
+    return new Promise((resolve, reject) => {
+      let result
+      worker.on('message', (message) => { result = message })
+      worker.on('error', reject)
+      worker.on('exit', (code) => code === 0 ? resolve(result) : reject(new Error(`Worker exited with code ${code}`)))
+    })
+  }
+
+  it('should load the addon in many workers concurrently', async function () {
+    this.timeout(20000)
+
+    const ids = Array.from({ length: 8 }, (_, id) => id)
+    const results = await Promise.all(ids.map(id => run(spawn(id))))
+
+    assert.deepStrictEqual(results, ids.map(id => ({ id, indexed: payload0 })))
+
+    for (const id of ids) {
+      assert.strictEqual(xattr.getAttributeSync(`${root}/file-${id}`, attribute1, { encoding: 'utf8' }), String(id))
+    }
+  })
+
+  it('should tear down workers cleanly', async function () {
+    this.timeout(20000)
+
+    const workers = Array.from({ length: 8 }, (_, id) => spawn(100 + id))
+    await Promise.all(workers.map(worker => worker.terminate()))
+
+    const index = xattr.openAttributeIndex(indexFile)
+    assert.strictEqual(index.get('', attribute0).toString(), payload0)
+    index.close()
+  })
+
+  after(function () {
+    for (const name of fs.readdirSync(root)) fs.unlinkSync(`${root}/${name}`)
+    fs.rmdirSync(root)
+    fs.unlinkSync(indexFile)
+  })
+})